@@ -0,0 +1,30 @@
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+#include "pi_args.h"
+
+// 64-bit count from plain decimal digits or a float like 1e11, 0 on success;
+// hex, inf and nan are rejected before strtod can take them
+int parse_size(const char* str, uint64_t* out) {
+    if (!isdigit((unsigned char) str[0]) && str[0] != '.') {
+        return -1;
+    }
+    if (strchr(str, 'x') || strchr(str, 'X')) {
+        return -1;
+    }
+    char* end;
+    double val = strtod(str, &end);
+    if (*end != '\0' || !(val >= 1.0) || val >= 18446744073709551616.0) {
+        return -1;
+    }
+    if (strchr(str, 'e') || strchr(str, 'E') || strchr(str, '.')) {
+        *out = (uint64_t) val;
+        return 0;
+    }
+    uint64_t count = strtoull(str, &end, 10);
+    if (*end != '\0' || count == 0) {
+        return -1;
+    }
+    *out = count;
+    return 0;
+}
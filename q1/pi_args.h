@@ -0,0 +1,8 @@
+#ifndef PI_ARGS_H
+#define PI_ARGS_H
+
+#include <stdint.h>
+
+int parse_size(const char* str, uint64_t* out);
+
+#endif /*PI_ARGS_H*/
@@ -0,0 +1,323 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "pi_bigint.h"
+
+void big_init(bigint* a) {
+    a->d = NULL;
+    a->n = 0;
+    a->cap = 0;
+    a->neg = 0;
+}
+
+void big_free(bigint* a) {
+    free(a->d);
+    big_init(a);
+}
+
+void big_swap(bigint* a, bigint* b) {
+    bigint t = *a;
+    *a = *b;
+    *b = t;
+}
+
+static void reserve(bigint* a, size_t n) {
+    if (n <= a->cap) return;
+    uint32_t* d = realloc(a->d, n * sizeof(uint32_t));
+    if (d == NULL) {
+        fprintf(stderr, "Out of memory for a %zu limb integer\n", n);
+        exit(EXIT_FAILURE);
+    }
+    a->d = d;
+    a->cap = n;
+}
+
+static void* xcalloc(size_t n, size_t size) {
+    void* p = calloc(n, size);
+    if (p == NULL) {
+        fprintf(stderr, "Out of memory for %zu limbs\n", n);
+        exit(EXIT_FAILURE);
+    }
+    return p;
+}
+
+// drop leading zero limbs, zero is never negative
+static void trim(bigint* a) {
+    while (a->n > 0 && a->d[a->n - 1] == 0) a->n--;
+    if (a->n == 0) a->neg = 0;
+}
+
+void big_copy(bigint* r, const bigint* a) {
+    if (r == a) return;
+    reserve(r, a->n);
+    if (a->n) memcpy(r->d, a->d, a->n * sizeof(uint32_t));
+    r->n = a->n;
+    r->neg = a->neg;
+}
+
+void big_set_u64(bigint* a, uint64_t v) {
+    reserve(a, 3);
+    a->n = 0;
+    a->neg = 0;
+    while (v > 0) {
+        a->d[a->n++] = (uint32_t) (v % BIG_BASE);
+        v /= BIG_BASE;
+    }
+}
+
+// BIG_BASE^k
+void big_pow_base(bigint* r, size_t k) {
+    reserve(r, k + 1);
+    memset(r->d, 0, k * sizeof(uint32_t));
+    r->d[k] = 1;
+    r->n = k + 1;
+    r->neg = 0;
+}
+
+// a * BIG_BASE^limbs, a negative count drops the low limbs (rounds toward 0)
+void big_shift(bigint* r, const bigint* a, long limbs) {
+    bigint t;
+    big_init(&t);
+    if (limbs >= 0) {
+        reserve(&t, a->n + limbs);
+        memset(t.d, 0, limbs * sizeof(uint32_t));
+        if (a->n) memcpy(t.d + limbs, a->d, a->n * sizeof(uint32_t));
+        t.n = a->n ? a->n + limbs : 0;
+    } else if ((size_t) -limbs < a->n) {
+        t.n = a->n - (size_t) -limbs;
+        reserve(&t, t.n);
+        memcpy(t.d, a->d + -limbs, t.n * sizeof(uint32_t));
+    }
+    t.neg = a->neg;
+    trim(&t);
+    big_swap(r, &t);
+    big_free(&t);
+}
+
+static int cmp_raw(const uint32_t* a, size_t na, const uint32_t* b, size_t nb) {
+    if (na != nb) return na < nb ? -1 : 1;
+    for(size_t i = na; i-- > 0;) {
+        if (a[i] != b[i]) return a[i] < b[i] ? -1 : 1;
+    }
+    return 0;
+}
+
+// r = a + b for na >= nb, r has room for na + 1 limbs; returns the length
+static size_t add_raw(uint32_t* r, const uint32_t* a, size_t na, const uint32_t* b, size_t nb) {
+    uint32_t carry = 0;
+    for(size_t i = 0; i < na; i++) {
+        uint32_t s = a[i] + (i < nb ? b[i] : 0) + carry;
+        carry = s >= BIG_BASE;
+        r[i] = carry ? s - BIG_BASE : s;
+    }
+    r[na] = carry;
+    return na + carry;
+}
+
+// r = a - b for a >= b
+static void sub_raw(uint32_t* r, const uint32_t* a, size_t na, const uint32_t* b, size_t nb) {
+    uint32_t borrow = 0;
+    for(size_t i = 0; i < na; i++) {
+        uint32_t s = (i < nb ? b[i] : 0) + borrow;
+        borrow = a[i] < s;
+        r[i] = borrow ? a[i] + BIG_BASE - s : a[i] - s;
+    }
+}
+
+// r += x, the sum has to fit in the nr limbs of r
+static void add_into(uint32_t* r, size_t nr, const uint32_t* x, size_t nx) {
+    uint32_t carry = 0;
+    size_t i = 0;
+    for(; i < nx; i++) {
+        uint32_t s = r[i] + x[i] + carry;
+        carry = s >= BIG_BASE;
+        r[i] = carry ? s - BIG_BASE : s;
+    }
+    for(; carry && i < nr; i++) {
+        uint32_t s = r[i] + 1;
+        carry = s >= BIG_BASE;
+        r[i] = carry ? 0 : s;
+    }
+}
+
+// r -= x for r >= x
+static void sub_from(uint32_t* r, size_t nr, const uint32_t* x, size_t nx) {
+    uint32_t borrow = 0;
+    size_t i = 0;
+    for(; i < nx; i++) {
+        uint32_t s = x[i] + borrow;
+        borrow = r[i] < s;
+        r[i] = borrow ? r[i] + BIG_BASE - s : r[i] - s;
+    }
+    for(; borrow && i < nr; i++) {
+        borrow = r[i] == 0;
+        r[i] = borrow ? BIG_BASE - 1 : r[i] - 1;
+    }
+}
+
+// r[0, na + nb) = a * b. Products are collected in 64-bit columns and the
+// carries are only pushed through every 16 rows, before a column can overflow.
+static void mul_school(uint32_t* r, const uint32_t* a, size_t na, const uint32_t* b, size_t nb) {
+    uint64_t stack[4 * KARA_CUTOFF];
+    size_t n = na + nb;
+    uint64_t* acc = n <= 4 * KARA_CUTOFF ? stack : xcalloc(n, sizeof(uint64_t));
+    if (acc == stack) memset(acc, 0, n * sizeof(uint64_t));
+
+    size_t row = 0;
+    for(size_t i = 0; i < na; i++) {
+        uint64_t ai = a[i];
+        for(size_t j = 0; j < nb; j++) {
+            acc[i + j] += ai * b[j];
+        }
+        if ((i & 15) == 15 || i == na - 1) {
+            uint64_t carry = 0;
+            for(size_t k = row; k < i + nb; k++) {
+                uint64_t v = acc[k] + carry;
+                acc[k] = v % BIG_BASE;
+                carry = v / BIG_BASE;
+            }
+            if (i + nb < n) acc[i + nb] += carry;
+            row = i + 1;
+        }
+    }
+    for(size_t k = 0; k < n; k++) {
+        r[k] = (uint32_t) acc[k];
+    }
+    if (acc != stack) free(acc);
+}
+
+// r[0, 2n) = a * b for two n limb numbers
+static void kara(uint32_t* r, const uint32_t* a, const uint32_t* b, size_t n) {
+    if (n < KARA_CUTOFF) {
+        mul_school(r, a, n, b, n);
+        return;
+    }
+    // a = a1 * B^m + a0, likewise b; the high halves get the extra limb
+    size_t m = n / 2;
+    size_t h = n - m;
+
+    // z0 = a0 * b0 and z2 = a1 * b1 go straight to their place in r
+    kara(r, a, b, m);
+    kara(r + 2 * m, a + m, b + m, h);
+
+    // z1 = (a0 + a1)(b0 + b1) - z0 - z2
+    uint32_t* tmp = xcalloc(4 * (h + 1), sizeof(uint32_t));
+    uint32_t* sa = tmp;
+    uint32_t* sb = tmp + (h + 1);
+    uint32_t* z1 = tmp + 2 * (h + 1);
+    add_raw(sa, a + m, h, a, m);
+    add_raw(sb, b + m, h, b, m);
+    kara(z1, sa, sb, h + 1);
+    sub_from(z1, 2 * (h + 1), r, 2 * m);
+    sub_from(z1, 2 * (h + 1), r + 2 * m, 2 * h);
+
+    size_t nz = 2 * (h + 1);
+    while (nz > 0 && z1[nz - 1] == 0) nz--;
+    add_into(r + m, 2 * n - m, z1, nz);
+    free(tmp);
+}
+
+// r[0, na + nb) = a * b, the longer number is cut in pieces the length of
+// the shorter one so Karatsuba always gets two equal halves
+static void mul_raw(uint32_t* r, const uint32_t* a, size_t na, const uint32_t* b, size_t nb) {
+    if (na < nb) {
+        const uint32_t* t = a; a = b; b = t;
+        size_t tn = na; na = nb; nb = tn;
+    }
+    if (nb < KARA_CUTOFF) {
+        mul_school(r, a, na, b, nb);
+        return;
+    }
+    if (na == nb) {
+        kara(r, a, b, na);
+        return;
+    }
+
+    memset(r, 0, (na + nb) * sizeof(uint32_t));
+    uint32_t* part = xcalloc(2 * nb, sizeof(uint32_t));
+    for(size_t off = 0; off < na; off += nb) {
+        size_t len = na - off < nb ? na - off : nb;
+        mul_raw(part, a + off, len, b, nb);
+        add_into(r + off, na + nb - off, part, len + nb);
+    }
+    free(part);
+}
+
+void big_mul(bigint* r, const bigint* a, const bigint* b) {
+    bigint t;
+    big_init(&t);
+    if (a->n && b->n) {
+        reserve(&t, a->n + b->n);
+        mul_raw(t.d, a->d, a->n, b->d, b->n);
+        t.n = a->n + b->n;
+        t.neg = a->neg != b->neg;
+        trim(&t);
+    }
+    big_swap(r, &t);
+    big_free(&t);
+}
+
+// r = a + b with b negated when flip is set
+static void add_signed(bigint* r, const bigint* a, const bigint* b, int flip) {
+    int bneg = b->neg ^ flip;
+    bigint t;
+    big_init(&t);
+    if (a->neg == bneg) {
+        const bigint* x = a->n >= b->n ? a : b;
+        const bigint* y = a->n >= b->n ? b : a;
+        reserve(&t, x->n + 1);
+        t.n = add_raw(t.d, x->d, x->n, y->d, y->n);
+        t.neg = a->neg;
+    } else {
+        int c = cmp_raw(a->d, a->n, b->d, b->n);
+        const bigint* x = c >= 0 ? a : b;
+        const bigint* y = c >= 0 ? b : a;
+        reserve(&t, x->n);
+        sub_raw(t.d, x->d, x->n, y->d, y->n);
+        t.n = x->n;
+        t.neg = c >= 0 ? a->neg : bneg;
+    }
+    trim(&t);
+    big_swap(r, &t);
+    big_free(&t);
+}
+
+void big_add(bigint* r, const bigint* a, const bigint* b) {
+    add_signed(r, a, b, 0);
+}
+
+void big_sub(bigint* r, const bigint* a, const bigint* b) {
+    add_signed(r, a, b, 1);
+}
+
+void big_mul_small(bigint* r, const bigint* a, uint32_t s) {
+    reserve(r, a->n + 2);
+    uint64_t carry = 0;
+    for(size_t i = 0; i < a->n; i++) {
+        uint64_t v = (uint64_t) a->d[i] * s + carry;
+        r->d[i] = (uint32_t) (v % BIG_BASE);
+        carry = v / BIG_BASE;
+    }
+    size_t n = a->n;
+    while (carry > 0) {
+        r->d[n++] = (uint32_t) (carry % BIG_BASE);
+        carry /= BIG_BASE;
+    }
+    r->n = n;
+    r->neg = a->neg;
+    trim(r);
+}
+
+// r = a / s, rounded toward 0
+void big_div_small(bigint* r, const bigint* a, uint32_t s) {
+    reserve(r, a->n);
+    uint64_t rem = 0;
+    for(size_t i = a->n; i-- > 0;) {
+        uint64_t v = rem * BIG_BASE + a->d[i];
+        r->d[i] = (uint32_t) (v / s);
+        rem = v % s;
+    }
+    r->n = a->n;
+    r->neg = a->neg;
+    trim(r);
+}
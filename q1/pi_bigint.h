@@ -0,0 +1,36 @@
+#ifndef PI_BIGINT_H
+#define PI_BIGINT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Signed big integers in base 10^9, least significant limb first. The decimal
+// base makes printing the digits of a result a plain walk over the limbs.
+#define BIG_BASE 1000000000U
+#define BIG_DIGITS 9
+
+// below this many limbs Karatsuba falls back to schoolbook multiplication
+#define KARA_CUTOFF 40
+
+typedef struct {
+    uint32_t* d;
+    size_t n;       // limbs in use, 0 for zero; the top limb is never 0
+    size_t cap;
+    int neg;
+} bigint;
+
+void big_init(bigint* a);
+void big_free(bigint* a);
+void big_swap(bigint* a, bigint* b);
+void big_copy(bigint* r, const bigint* a);
+void big_set_u64(bigint* a, uint64_t v);
+void big_pow_base(bigint* r, size_t k);
+void big_shift(bigint* r, const bigint* a, long limbs);
+
+void big_add(bigint* r, const bigint* a, const bigint* b);
+void big_sub(bigint* r, const bigint* a, const bigint* b);
+void big_mul(bigint* r, const bigint* a, const bigint* b);
+void big_mul_small(bigint* r, const bigint* a, uint32_t s);
+void big_div_small(bigint* r, const bigint* a, uint32_t s);
+
+#endif /*PI_BIGINT_H*/
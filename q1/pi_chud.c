@@ -0,0 +1,216 @@
+#include <math.h>
+#include <stdlib.h>
+#include "pi_chud.h"
+
+void chud_init(chud_part* p) {
+    big_init(&p->P);
+    big_init(&p->Q);
+    big_init(&p->T);
+}
+
+void chud_free(chud_part* p) {
+    big_free(&p->P);
+    big_free(&p->Q);
+    big_free(&p->T);
+}
+
+// terms needed for the given number of digits
+uint64_t chud_terms(uint64_t digits) {
+    return (uint64_t) (digits / CHUD_DIGITS_PER_TERM) + 2;
+}
+
+// fixed point limbs after the point for the digits, with two guard limbs
+size_t chud_limbs(uint64_t digits) {
+    return (size_t) (digits / BIG_DIGITS) + 3;
+}
+
+// term a on its own: P = (6a - 5)(2a - 1)(6a - 1), Q = a^3 640320^3 / 24 and
+// T = (-1)^a P (13591409 + 545140134 a); P = Q = 1 for a = 0
+static void chud_leaf(chud_part* r, uint64_t a) {
+    if (a == 0) {
+        big_set_u64(&r->P, 1);
+        big_set_u64(&r->Q, 1);
+    } else {
+        big_set_u64(&r->P, 6 * a - 5);
+        big_mul_small(&r->P, &r->P, (uint32_t) (2 * a - 1));
+        big_mul_small(&r->P, &r->P, (uint32_t) (6 * a - 1));
+        big_set_u64(&r->Q, a);
+        big_mul_small(&r->Q, &r->Q, (uint32_t) a);
+        big_mul_small(&r->Q, &r->Q, (uint32_t) a);
+        big_mul_small(&r->Q, &r->Q, 640320);
+        big_mul_small(&r->Q, &r->Q, 640320);
+        big_mul_small(&r->Q, &r->Q, 26680);
+    }
+    bigint f;
+    big_init(&f);
+    big_set_u64(&f, 13591409 + 545140134 * a);
+    big_mul(&r->T, &r->P, &f);
+    big_free(&f);
+    if ((a & 1) && r->T.n) r->T.neg = !r->T.neg;
+}
+
+// binary splitting of the terms [a, b); P is only needed on the left of a merge
+void chud_split(chud_part* r, uint64_t a, uint64_t b, int need_p) {
+    if (b - a == 1) {
+        chud_leaf(r, a);
+        return;
+    }
+    uint64_t m = (a + b) / 2;
+    chud_part right;
+    chud_init(&right);
+    chud_split(r, a, m, 1);
+    chud_split(&right, m, b, need_p);
+    chud_merge(r, &right, need_p);
+    chud_free(&right);
+}
+
+// one of the products of merging left and right
+void chud_multiply(bigint* out, chud_product k, const chud_part* left, const chud_part* right) {
+    switch (k) {
+        case CHUD_PP: big_mul(out, &left->P, &right->P); break;
+        case CHUD_QQ: big_mul(out, &left->Q, &right->Q); break;
+        case CHUD_TQ: big_mul(out, &left->T, &right->Q); break;
+        case CHUD_PT: big_mul(out, &left->P, &right->T); break;
+    }
+}
+
+// left becomes the merge from its products: P = P1 P2, Q = Q1 Q2, T = T1 Q2 + P1 T2
+void chud_combine(chud_part* left, bigint prod[4], int need_p) {
+    if (need_p) {
+        big_swap(&left->P, &prod[CHUD_PP]);
+    } else {
+        big_free(&left->P);
+    }
+    big_swap(&left->Q, &prod[CHUD_QQ]);
+    big_add(&left->T, &prod[CHUD_TQ], &prod[CHUD_PT]);
+}
+
+void chud_merge(chud_part* left, const chud_part* right, int need_p) {
+    bigint prod[4];
+    for(int k = 0; k < 4; k++) {
+        big_init(&prod[k]);
+        if (k != CHUD_PP || need_p) chud_multiply(&prod[k], (chud_product) k, left, right);
+    }
+    chud_combine(left, prod, need_p);
+    for(int k = 0; k < 4; k++) {
+        big_free(&prod[k]);
+    }
+}
+
+// Newton steps run at about double the precision of the one before, these are
+// the limbs of each step up to limbs, smallest first; returns the count
+static int newton_steps(size_t limbs, size_t start, size_t steps[64]) {
+    int n = 0;
+    for(size_t p = limbs; n < 64; p = p / 2 + 1) {
+        steps[n++] = p;
+        if (p <= start + 1) break;
+    }
+    // smallest first, with one more step at full precision to clean up
+    for(int i = 0; i < n / 2; i++) {
+        size_t t = steps[i];
+        steps[i] = steps[n - 1 - i];
+        steps[n - 1 - i] = t;
+    }
+    steps[n++] = limbs;
+    return n;
+}
+
+// 1 / sqrt(10005) scaled by BIG_BASE^limbs: y += y (1 - 10005 y^2) / 2
+void chud_inv_sqrt(bigint* y, size_t limbs) {
+    size_t steps[65];
+    int n = newton_steps(limbs, 2, steps);
+    size_t cur = 2;
+    big_set_u64(y, (uint64_t) (1e18L / sqrtl(10005.0L)));
+
+    bigint e, one;
+    big_init(&e);
+    big_init(&one);
+    for(int i = 0; i < n; i++) {
+        size_t p = steps[i];
+        big_shift(y, y, (long) p - (long) cur);
+        cur = p;
+        big_mul(&e, y, y);
+        big_mul_small(&e, &e, 10005);
+        big_pow_base(&one, 2 * p);
+        big_sub(&e, &one, &e);
+        big_shift(&e, &e, -(long) p);
+        big_mul(&e, y, &e);
+        big_shift(&e, &e, -(long) p);
+        big_div_small(&e, &e, 2);
+        big_add(y, y, &e);
+    }
+    big_free(&e);
+    big_free(&one);
+}
+
+// B^n / t scaled by B^limbs for the n limb integer t (B = BIG_BASE), that is
+// 1 / t' for the fraction t' = t / B^n: x += x (1 - t' x)
+void chud_recip(bigint* x, const bigint* t, size_t limbs) {
+    size_t steps[65];
+    int n = newton_steps(limbs, 1, steps);
+    size_t cur = 1;
+    // start from the top limbs: tf = t / B^(n - 1) is in [1, B), so the
+    // first x = B / t' = B^2 / tf fits in 64 bits
+    long double tf = 0.0L, scale = 1.0L;
+    for(size_t i = 0; i < 3 && i < t->n; i++) {
+        tf += t->d[t->n - 1 - i] * scale;
+        scale /= BIG_BASE;
+    }
+    big_set_u64(x, (uint64_t) (1e18L / tf));
+
+    bigint tp, e, one;
+    big_init(&tp);
+    big_init(&e);
+    big_init(&one);
+    for(int i = 0; i < n; i++) {
+        size_t p = steps[i];
+        big_shift(x, x, (long) p - (long) cur);
+        cur = p;
+        big_shift(&tp, t, (long) p - (long) t->n);
+        big_mul(&e, &tp, x);
+        big_pow_base(&one, 2 * p);
+        big_sub(&e, &one, &e);
+        big_shift(&e, &e, -(long) p);
+        big_mul(&e, x, &e);
+        big_shift(&e, &e, -(long) p);
+        big_add(x, x, &e);
+    }
+    big_free(&tp);
+    big_free(&e);
+    big_free(&one);
+}
+
+// pi = 426880 * 10005 * (1 / sqrt(10005)) * Q / T scaled by BIG_BASE^limbs
+void chud_pi(bigint* pi, const chud_part* top, const bigint* inv_sqrt, size_t limbs) {
+    bigint x, q;
+    big_init(&x);
+    big_init(&q);
+
+    // Q / T = (Q / B^n) / (T / B^n) for the n limbs of T
+    chud_recip(&x, &top->T, limbs);
+    big_mul(pi, inv_sqrt, &x);
+    big_shift(pi, pi, -(long) limbs);
+    big_shift(&q, &top->Q, (long) limbs - (long) top->T.n);
+    big_mul(pi, pi, &q);
+    big_shift(pi, pi, -(long) limbs);
+    big_mul_small(pi, pi, 426880);
+    big_mul_small(pi, pi, 10005);
+
+    big_free(&x);
+    big_free(&q);
+}
+
+// write the digits [from, from + count) after the point of pi scaled by
+// BIG_BASE^limbs, one limb at a time
+void chud_digits(const bigint* pi, size_t limbs, uint64_t from, uint64_t count, FILE* out) {
+    uint64_t end = from + count;
+    for(uint64_t limb = from / BIG_DIGITS; limb * BIG_DIGITS < end && limb < limbs; limb++) {
+        uint32_t v = limbs - 1 - limb < pi->n ? pi->d[limbs - 1 - limb] : 0;
+        char buf[BIG_DIGITS + 1];
+        snprintf(buf, sizeof(buf), "%09u", v);
+        uint64_t lo = limb * BIG_DIGITS;
+        int a = from > lo ? (int) (from - lo) : 0;
+        int b = end < lo + BIG_DIGITS ? (int) (end - lo) : BIG_DIGITS;
+        fwrite(buf + a, 1, b - a, out);
+    }
+}
@@ -0,0 +1,45 @@
+#ifndef PI_CHUD_H
+#define PI_CHUD_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include "pi_bigint.h"
+
+// -p number of the arbitrary precision method, after the series ones
+#define PI_CHUDNOVSKY 5
+
+// decimal digits every term of the Chudnovsky series adds
+#define CHUD_DIGITS_PER_TERM 14.181647462725477
+
+// P, Q and T of the terms [a, b) in the binary splitting of
+// pi = 426880 sqrt(10005) Q(0, n) / T(0, n)
+typedef struct {
+    bigint P;
+    bigint Q;
+    bigint T;
+} chud_part;
+
+// the four products of a merge; P1 * P2 is skipped when no P is needed
+typedef enum {
+    CHUD_PP,    // P1 * P2
+    CHUD_QQ,    // Q1 * Q2
+    CHUD_TQ,    // T1 * Q2
+    CHUD_PT     // P1 * T2
+} chud_product;
+
+void chud_init(chud_part* p);
+void chud_free(chud_part* p);
+uint64_t chud_terms(uint64_t digits);
+size_t chud_limbs(uint64_t digits);
+
+void chud_split(chud_part* r, uint64_t a, uint64_t b, int need_p);
+void chud_multiply(bigint* out, chud_product k, const chud_part* left, const chud_part* right);
+void chud_combine(chud_part* left, bigint prod[4], int need_p);
+void chud_merge(chud_part* left, const chud_part* right, int need_p);
+
+void chud_inv_sqrt(bigint* y, size_t limbs);
+void chud_recip(bigint* x, const bigint* t, size_t limbs);
+void chud_pi(bigint* pi, const chud_part* top, const bigint* inv_sqrt, size_t limbs);
+void chud_digits(const bigint* pi, size_t limbs, uint64_t from, uint64_t count, FILE* out);
+
+#endif /*PI_CHUD_H*/
@@ -1,24 +1,38 @@
 #include <omp.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <math.h>
 #include <time.h>
 #include <stdint.h>
 #include <unistd.h>
+#include "pi_omp.h"
+#include "pi_rng.h"
+#include "pi_simd.h"
+#include "pi_sum.h"
+#include "pi_series.h"
+#include "pi_chud.h"
+#include "pi_stats.h"
+#include "pi_args.h"
 
-static long num_trials = 1000000;
+static uint64_t num_trials = 1000000;
 
-// thread local random seed
-__thread unsigned int thread_seed;
+// every run draws from one reproducible sequence picked by the generator and seed
+static rng_kind rng_type = RNG_PHILOX;
+static uint64_t rng_seed = 1;
+static simd_level simd = SIMD_SCALAR;
 
-// initialize the random number generator for each thread
-void intialize_thread_seed() {
-    thread_seed = time(NULL) ^ (unsigned int) omp_get_thread_num(); 
-}
+// how the Liebniz terms are added, and whether the result may depend on the
+// split (0) or is reduced from fixed blocks in a fixed order (1)
+static sum_mode sum_type = SUM_NAIVE;
+static int sum_fixed = 0;
 
-// returns a random number from 0 to RAND_MAX
-int get_rand() {
-    return rand_r(&thread_seed);
-}
+// file the Chudnovsky digits are written to, none when NULL
+static const char* digits_file = NULL;
+
+// adaptive Monte-Carlo: stop once the half width of the confidence interval
+// at mc_level is at most mc_tolerance, off when mc_tolerance is 0
+static double mc_tolerance = 0.0;
+static double mc_level = 0.95;
 
 // initialize clock
 double CLOCK() {
@@ -27,32 +41,96 @@ double CLOCK() {
     return (t.tv_sec * 1000) + (t.tv_nsec*1e-6);
 }
 
-int monte_carlo_pi() {
-    long i; long num_circle = 0;
-    double pi, x, y, dist;
+// points in the circle among samples [base, base + size), the threads take
+// contiguous blocks; sample i uses doubles 2i and 2i + 1 of the sequence so
+// the hits do not depend on the split
+static uint64_t monte_carlo_count(uint64_t base, uint64_t size) {
+    uint64_t num_circle = 0;
+    #pragma omp parallel reduction(+:num_circle)
+    {
+        uint64_t nThreads = omp_get_num_threads();
+        uint64_t t = omp_get_thread_num();
+        uint64_t first = base + t * (size / nThreads) + (t < size % nThreads ? t : size % nThreads);
+        uint64_t count = size / nThreads + (t < size % nThreads ? 1 : 0);
+
+        // Philox points are made and counted in vector registers, xoshiro
+        // points are drawn in batches and counted after
+        if (rng_type == RNG_PHILOX) {
+            num_circle += pi_simd.count_philox(rng_seed, first, (long) count);
+        } else {
+            rng_stream rng;
+            rng_seek(&rng, rng_type, rng_seed, 2 * first);
+            double points[2 * MC_BATCH];
+
+            for(uint64_t done = 0; done < count; done += MC_BATCH) {
+                int n = (count - done < MC_BATCH) ? (int) (count - done) : MC_BATCH;
+                rng_fill(&rng, points, 2 * n);
+                num_circle += pi_simd.count_points(points, n);
+            }
+        }
+    }
+    return num_circle;
+}
+
+// Adaptive Monte Carlo: rounds of samples [n, n + round) until the confidence
+// interval is narrow enough or num_trials samples are used, with the same
+// rounds as pi_pthread
+static int monte_carlo_adaptive() {
+    double z = normal_quantile(mc_level);
+    uint64_t n = 0, num_circle = 0;
+    int rounds = 0;
     double t1, total;
 
-    t1 = CLOCK();
+    printf("Target: +/- %g at %g%% confidence (z = %0.4f)\n", mc_tolerance, 100.0 * mc_level, z);
+    printf("Generator: %s (seed %llu), kernels: %s\n", rng_name(rng_type), (unsigned long long) rng_seed, simd_name(simd));
     #pragma omp parallel
-    {   
-        intialize_thread_seed();
-
+    {
         #pragma omp single
           printf(" %d threads \n",omp_get_num_threads());
-        
-        #pragma omp for reduction(+:num_circle) private(x,y,dist)
-        for(i = 0; i < num_trials; i++) {
-            x = ((double) (get_rand() % (num_trials + 1))) / (double) num_trials;
-            y = ((double) (get_rand() % (num_trials + 1))) / (double) num_trials;
+    }
+
+    t1 = CLOCK();
+    while (n < num_trials && !(n > 0 && z * mc_std_error(num_circle, n) <= mc_tolerance)) {
+        uint64_t round = mc_next_round(num_circle, n, z, mc_tolerance, num_trials - n);
+        num_circle += monte_carlo_count(n, round);
+        n += round;
+        rounds++;
+    }
+    total = CLOCK() - t1;
 
-            dist = x*x + y*y;
+    double pi = 4.0 * ((double) num_circle / (double) n);
+    double err = mc_std_error(num_circle, n);
 
-            if (dist <= 1.0) {
-                num_circle++;
-            }
-        }
+    // print result
+    printf("------ Monte Carlo Result ------\n");
+    printf("Time Elapsed: %0.3f ms\n", total);
+    printf("Samples Used: %llu in %d rounds\n", (unsigned long long) n, rounds);
+    printf("Points in Circle: %llu\n", (unsigned long long) num_circle);
+    printf("Estimation of Pi: %0.9lf +/- %0.3e\n", pi, z * err);
+    printf("Standard Error: %0.3e\n", err);
+    printf("Target Reached: %s\n", z * err <= mc_tolerance ? "yes" : "no, out of samples");
+
+    return 0;
+}
+
+int monte_carlo_pi() {
+    uint64_t num_circle = 0;
+    double pi;
+    double t1, total;
+
+    if (mc_tolerance > 0.0) {
+        return monte_carlo_adaptive();
     }
 
+    printf("Generator: %s (seed %llu), kernels: %s\n", rng_name(rng_type), (unsigned long long) rng_seed, simd_name(simd));
+    #pragma omp parallel
+    {
+        #pragma omp single
+          printf(" %d threads \n",omp_get_num_threads());
+    }
+    t1 = CLOCK();
+    num_circle = monte_carlo_count(0, num_trials);
+
     // get pi estimation
     pi = 4.0 * ((double)num_circle / (double)num_trials);
     
@@ -62,31 +140,55 @@ int monte_carlo_pi() {
     // print result
     printf("------ Monte Carlo Result ------\n");
     printf("Time Elapsed: %0.3f ms\n", total);
-    printf("Points in Circle: %ld\n", num_circle);
+    printf("Points in Circle: %llu\n", (unsigned long long) num_circle);
     printf("Estimation of Pi: %lf\n", pi);
 
     return 0;
 }
 
-double liebniz_sum(long i) {
-    return (i % 2 == 0) ? (1.0 / (double) (2 * i + 1)) : (-1.0 / (double) (2 * i + 1));
-}
-
 int liebniz_pi() {
-    long i;
     double pi, sum = 0.0;
     double t1, total;
 
+    printf("Summation: %s%s\n", sum_name(sum_type), sum_fixed ? ", deterministic" : "");
+
     // begin benchmark
     t1 = CLOCK();
-    #pragma omp parallel 
-    {
-        #pragma omp single
-        printf(" %d threads \n",omp_get_num_threads());
+    if (sum_fixed) {
+        // same SUM_BLOCK blocks and tree as pi_pthread, so the sum does not
+        // depend on the threads or on the program
+        uint64_t nblocks = (num_trials + SUM_BLOCK - 1) / SUM_BLOCK;
+        double* blocks = malloc(nblocks * sizeof(double));
+        if (blocks == NULL) {
+            fprintf(stderr, "Out of memory for %llu blocks\n", (unsigned long long) nblocks);
+            exit(EXIT_FAILURE);
+        }
+        #pragma omp parallel
+        {
+            #pragma omp single
+            printf(" %d threads \n",omp_get_num_threads());
+
+            #pragma omp for schedule(dynamic)
+            for(uint64_t b = 0; b < nblocks; b++) {
+                uint64_t lower = b * SUM_BLOCK;
+                uint64_t n = num_trials - lower < SUM_BLOCK ? num_trials - lower : SUM_BLOCK;
+                blocks[b] = liebniz_range(sum_type, lower, n);
+            }
+        }
+        sum = sum_tree(blocks, nblocks);
+        free(blocks);
+    } else {
+        #pragma omp parallel reduction(+:sum)
+        {
+            #pragma omp single
+            printf(" %d threads \n",omp_get_num_threads());
 
-        #pragma omp for reduction(+:sum)
-        for(i=0; i < num_trials; i++) {
-            sum += liebniz_sum(i);
+            // contiguous block of terms for this thread
+            uint64_t nThreads = omp_get_num_threads();
+            uint64_t t = omp_get_thread_num();
+            uint64_t first = t * (num_trials / nThreads) + (t < num_trials % nThreads ? t : num_trials % nThreads);
+            uint64_t count = num_trials / nThreads + (t < num_trials % nThreads ? 1 : 0);
+            sum += liebniz_range(sum_type, first, count);
         }
     }
 
@@ -101,32 +203,200 @@ int liebniz_pi() {
     printf("Time Elapsed: %0.3f ms\n", total);
     printf("Liebniz Sum: %lf\n", sum);
     printf("Estimation of Pi: %0.12lf\n", pi);
+    printf("Error: %0.3e\n", fabs(pi - PI_REFERENCE));
+
+    return 0;
+}
+
+int series_pi(series_method method) {
+    double pi = 0.0;
+    double t1, total;
+
+    // the terms past the double range add nothing, do not hand them out
+    uint64_t terms = series_terms(method, num_trials);
+
+    t1 = CLOCK();
+    #pragma omp parallel reduction(+:pi)
+    {
+        #pragma omp single
+        printf(" %d threads \n",omp_get_num_threads());
+
+        // contiguous block of terms for this thread
+        uint64_t nThreads = omp_get_num_threads();
+        uint64_t t = omp_get_thread_num();
+        uint64_t first = t * (terms / nThreads) + (t < terms % nThreads ? t : terms % nThreads);
+        uint64_t count = terms / nThreads + (t < terms % nThreads ? 1 : 0);
+        pi += series_range(method, first, count);
+    }
+    total = CLOCK() - t1;
+
+    // print result
+    printf("------ %s Result ------\n", series_name(method));
+    printf("Time Elapsed: %0.3f ms\n", total);
+    printf("Terms: %llu\n", (unsigned long long) terms);
+    printf("Estimation of Pi: %0.15lf\n", pi);
+    printf("Error: %0.3e\n", fabs(pi - PI_REFERENCE));
 
     return 0;
 }
 
+// hex digits [position, position + n) of pi, each computed on its own
+int bbp_digits_pi(uint64_t position, uint64_t n) {
+    double t1, total;
+    char* digits = malloc(n + 1);
+    if (digits == NULL) {
+        fprintf(stderr, "Out of memory for %llu digits\n", (unsigned long long) n);
+        exit(EXIT_FAILURE);
+    }
+    digits[n] = '\0';
+
+    printf("Position: %llu, Digits: %llu\n", (unsigned long long) position, (unsigned long long) n);
+    t1 = CLOCK();
+    #pragma omp parallel
+    {
+        #pragma omp single
+        printf(" %d threads \n",omp_get_num_threads());
+
+        // the cost of a digit grows with its position, hand them out one by one
+        #pragma omp for schedule(dynamic, 1)
+        for(uint64_t i = 0; i < n; i++) {
+            digits[i] = "0123456789ABCDEF"[bbp_hex_digit(position + i)];
+        }
+    }
+    total = CLOCK() - t1;
+
+    printf("------ BBP Digit Extraction Result ------\n");
+    printf("Time Elapsed: %0.3f ms\n", total);
+    printf("Hex Digits: %s\n", digits);
+
+    free(digits);
+    return 0;
+}
+
+// Binary splitting of the terms [a, b) as a tree of tasks. Below
+// CHUD_TASK_TERMS terms a task splits on its own, above it the two halves and
+// then the products of their merge run as tasks.
+static void chud_split_task(chud_part* r, uint64_t a, uint64_t b, int need_p) {
+    if (b - a < CHUD_TASK_TERMS) {
+        chud_split(r, a, b, need_p);
+        return;
+    }
+    uint64_t m = (a + b) / 2;
+    chud_part right;
+    chud_init(&right);
+
+    #pragma omp task shared(right)
+    chud_split_task(&right, m, b, need_p);
+    chud_split_task(r, a, m, 1);
+    #pragma omp taskwait
+
+    bigint prod[4];
+    for(int k = 0; k < 4; k++) {
+        big_init(&prod[k]);
+        if (k == CHUD_PP && !need_p) continue;
+        #pragma omp task shared(prod, right)
+        chud_multiply(&prod[k], (chud_product) k, r, &right);
+    }
+    #pragma omp taskwait
+
+    chud_combine(r, prod, need_p);
+    for(int k = 0; k < 4; k++) {
+        big_free(&prod[k]);
+    }
+    chud_free(&right);
+}
+
+int chudnovsky_pi(uint64_t digits) {
+    uint64_t terms = chud_terms(digits);
+    size_t limbs = chud_limbs(digits);
+    double t1, t2, total;
+    printf("Digits: %llu\n", (unsigned long long) digits);
+    printf("Terms: %llu\n", (unsigned long long) terms);
+
+    chud_part top;
+    bigint y, pi;
+    chud_init(&top);
+    big_init(&y);
+    big_init(&pi);
+
+    t1 = CLOCK();
+    #pragma omp parallel
+    {
+        #pragma omp single
+        {
+            printf(" %d threads \n",omp_get_num_threads());
+
+            // 1 / sqrt(10005) does not depend on the series, it runs next to it
+            #pragma omp task shared(y)
+            chud_inv_sqrt(&y, limbs);
+
+            chud_split_task(&top, 0, terms, 0);
+            #pragma omp taskwait
+        }
+    }
+    t2 = CLOCK();
+    chud_pi(&pi, &top, &y, limbs);
+    total = CLOCK() - t1;
+
+    // print result
+    printf("------ Chudnovsky Result ------\n");
+    printf("Time Elapsed: %0.3f ms (splitting %0.3f ms, division %0.3f ms)\n", total, t2 - t1, total - (t2 - t1));
+    printf("First Digits: 3.");
+    chud_digits(&pi, limbs, 0, digits < 50 ? digits : 50, stdout);
+    printf("\n");
+    if (digits > 50) {
+        printf("Last Digits: ...");
+        chud_digits(&pi, limbs, digits - 20, 20, stdout);
+        printf("\n");
+    }
+
+    int res = 0;
+    if (digits_file) {
+        // streamed a limb at a time, the digits are never held as text
+        FILE* fp = fopen(digits_file, "w");
+        if (fp == NULL) {
+            fprintf(stderr, "Could not open %s\n", digits_file);
+            res = 1;
+        } else {
+            fprintf(fp, "3.");
+            chud_digits(&pi, limbs, 0, digits, fp);
+            fprintf(fp, "\n");
+            fclose(fp);
+            printf("Digits written to %s\n", digits_file);
+        }
+    }
+
+    chud_free(&top);
+    big_free(&y);
+    big_free(&pi);
+    return res;
+}
+
 int main(int argc, char** argv) {
     int opt; 
     int part = 0;               // 0 - indicates approximation using monte-carlo method
                                 // 1 - indicates approximation using Leibniz's method
+                                // 2 - 4 the Euler, Machin and BBP series
+                                // 5 - digits with Chudnovsky binary splitting
+    uint64_t hex_position = 0;  // BBP digit extraction from this position
+    uint64_t hex_digits = 8;       // number of hex digits to extract
+    simd = simd_detect();
+
     // get user arguments
-    while((opt = getopt(argc, argv, "p:t:s:h")) != -1) {
+    while((opt = getopt(argc, argv, "p:t:s:r:g:k:m:dx:n:o:e:l:h")) != -1) {
         int temp;
         switch (opt) {
             case 'p':
                 temp = atoi(optarg);
-                if (temp >= 2 || temp < 0) {
+                if (temp > PI_CHUDNOVSKY || temp < 0) {
                     printf("Invalid Input for Pi Approximation Method. Using Monte-Carlo as default method.\n");
                 } else { 
                     part = temp; 
                 }
                 break;
             case 's':
-                temp = atol(optarg);
-                if (temp <= 0) {
-                    printf("Invalid input for sample size. Using default: %ld\n", num_trials);
-                } else {
-                    num_trials = temp;
+                if (parse_size(optarg, &num_trials) != 0) {
+                    printf("Invalid input for sample size. Using default: %llu\n", (unsigned long long) num_trials);
                 }
                 break;
             case 't':
@@ -137,21 +407,94 @@ int main(int argc, char** argv) {
                     omp_set_num_threads(temp);
                 }
                 break;
+            case 'r':
+                rng_seed = strtoull(optarg, NULL, 10);
+                break;
+            case 'g':
+                if (parse_rng(optarg, &rng_type) != 0) {
+                    printf("Invalid input for random generator. Using default: philox\n");
+                    rng_type = RNG_PHILOX;
+                }
+                break;
+            case 'k':
+                if (parse_simd(optarg, &simd) != 0) {
+                    printf("Invalid input for kernels. Using default: auto\n");
+                    simd = simd_detect();
+                }
+                break;
+            case 'm':
+                if (parse_sum(optarg, &sum_type) != 0) {
+                    printf("Invalid input for summation. Using default: naive\n");
+                    sum_type = SUM_NAIVE;
+                }
+                break;
+            case 'd':
+                sum_fixed = 1;
+                break;
+            case 'x':
+                if (parse_size(optarg, &hex_position) != 0) {
+                    printf("Invalid input for hex digit position.\n");
+                    hex_position = 0;
+                }
+                break;
+            case 'o':
+                digits_file = optarg;
+                break;
+            case 'e':
+                mc_tolerance = atof(optarg);
+                if (mc_tolerance <= 0.0) {
+                    printf("Invalid input for tolerance. Running the full sample size.\n");
+                    mc_tolerance = 0.0;
+                }
+                break;
+            case 'l':
+                mc_level = atof(optarg);
+                if (mc_level <= 0.0 || mc_level >= 1.0) {
+                    printf("Invalid input for confidence level. Using default: 0.95\n");
+                    mc_level = 0.95;
+                }
+                break;
+            case 'n':
+                if (parse_size(optarg, &hex_digits) != 0) {
+                    printf("Invalid input for number of hex digits. Using default: 8\n");
+                    hex_digits = 8;
+                }
+                break;
             case 'h':
-                printf("Usage: %s [-s size] [-t threads] [-h]\n", argv[0]);
+                printf("Usage: %s [-p method] [-s size] [-t threads] [-r seed] [-g generator] [-k kernels] [-m sum] [-d] [-x pos] [-n digits] [-o file] [-e tol] [-l level] [-h]\n", argv[0]);
                 printf("  -p method   Set the approximation method\n");
-                printf("              (0 -> Monte-Carlo | 1 -> Liebniz)\n");
+                printf("              (0 -> Monte-Carlo | 1 -> Liebniz | 2 -> Euler | 3 -> Machin | 4 -> BBP |\n");
+                printf("               5 -> Chudnovsky, -s digits)\n");
                 printf("  -s size     Set the sample size\n");
                 printf("  -t threads  Set the number of threads\n");
+                printf("  -r seed     Set the Monte-Carlo seed (Default: 1)\n");
+                printf("  -g gen      Set the random generator (philox | xoshiro)\n");
+                printf("  -k kernels  Set the Monte-Carlo kernels (auto | scalar | avx2 | avx512)\n");
+                printf("  -m sum      Set the Liebniz summation (naive | kahan | pairwise | paired)\n");
+                printf("  -d          Reduce the Liebniz sum in a fixed order, the same for any threads\n");
+                printf("  -x pos      Extract hex digits of pi from position pos with BBP\n");
+                printf("  -n digits   Set the number of hex digits to extract (Default: 8)\n");
+                printf("  -o file     Write the Chudnovsky digits to file\n");
+                printf("  -e tol      Stop the Monte-Carlo run once pi is within tol, -s is the most samples\n");
+                printf("  -l level    Set the confidence level of -e (Default: 0.95)\n");
                 printf("  -h          Display this help message\n");
                 return 0;
             default: /* '?' */
-                fprintf(stderr, "Usage: %s [-p method] [-s size] [-t threads] [-h]\n", argv[0]);
+                fprintf(stderr, "Usage: %s [-p method] [-s size] [-t threads] [-r seed] [-g generator] [-k kernels] [-m sum] [-d] [-x pos] [-n digits] [-o file] [-e tol] [-l level] [-h]\n", argv[0]);
                 exit(EXIT_FAILURE);
         }
     }
 
-    if (part) {
+    // falls back to the best instruction set the cpu has
+    simd = simd_select(simd);
+
+    if (hex_position) {
+        return bbp_digits_pi(hex_position, hex_digits);
+    } else if (part == PI_CHUDNOVSKY) {
+        return chudnovsky_pi(num_trials);
+    } else if (part >= SERIES_EULER) {
+        return series_pi((series_method) part);
+    } else if (part) {
         return liebniz_pi();
     } else {
         return monte_carlo_pi();
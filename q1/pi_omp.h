@@ -1,14 +1,24 @@
 #ifndef PI_OMP_H
 #define PI_OMP_H
 
-double CLOCK();
+#include <stdint.h>
+#include "pi_series.h"
+
+// terms below which a binary splitting task does not spawn more tasks
+#define CHUD_TASK_TERMS 256
+
+// points drawn per call to the random generator in each thread
+#define MC_BATCH 1024
 
-void intialize_thread_seed();
-int get_rand();
+double CLOCK();
 
 int monte_carlo_pi();
 
-double liebniz_sum(long i);
 int liebniz_pi();
 
+int series_pi(series_method method);
+int bbp_digits_pi(uint64_t position, uint64_t n);
+
+int chudnovsky_pi(uint64_t digits);
+
 #endif /*PI_OMP_H*/
\ No newline at end of file
@@ -0,0 +1,113 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <sched.h>
+#include "pi_pool.h"
+
+static void* pool_main(void* arg) {
+    pool_worker* w = (pool_worker*) arg;
+    pi_pool* pool = w->pool;
+    unsigned long seen = 0;
+
+    pthread_mutex_lock(&pool->lock);
+    for(;;) {
+        // park until a new job or the pool shuts down
+        while (pool->generation == seen && !pool->stop) {
+            pthread_cond_wait(&pool->start, &pool->lock);
+        }
+        if (pool->stop) break;
+        seen = pool->generation;
+        void* (*task)(void*) = pool->task;
+        void* args = pool->args + w->id * pool->stride;
+        pthread_mutex_unlock(&pool->lock);
+
+        task(args);
+
+        pthread_mutex_lock(&pool->lock);
+        if (--pool->running == 0) {
+            pthread_cond_signal(&pool->done);
+        }
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return NULL;
+}
+
+// pin worker id to the id-th cpu the process may run on, wrapping around
+static void pin_worker(pool_worker* w) {
+    cpu_set_t allowed, one;
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) return;
+    int count = CPU_COUNT(&allowed);
+    if (count == 0) return;
+
+    int target = w->id % count;
+    for(int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+        if (!CPU_ISSET(cpu, &allowed)) continue;
+        if (target-- == 0) {
+            CPU_ZERO(&one);
+            CPU_SET(cpu, &one);
+            pthread_setaffinity_np(w->th, sizeof(one), &one);
+            return;
+        }
+    }
+}
+
+// start nThreads workers, pinned to cores when pin is set; 0 on success
+int pool_init(pi_pool* pool, int nThreads, int pin) {
+    pool->nThreads = nThreads;
+    pool->generation = 0;
+    pool->running = 0;
+    pool->stop = 0;
+    pool->task = NULL;
+    pool->args = NULL;
+    pool->stride = 0;
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->start, NULL);
+    pthread_cond_init(&pool->done, NULL);
+
+    pool->workers = malloc(nThreads * sizeof(pool_worker));
+    if (pool->workers == NULL) return -1;
+
+    for(int i = 0; i < nThreads; i++) {
+        pool->workers[i].pool = pool;
+        pool->workers[i].id = i;
+        if (pthread_create(&pool->workers[i].th, NULL, pool_main, &pool->workers[i]) != 0) {
+            fprintf(stderr, "Could not create worker %d\n", i);
+            pool->nThreads = i;
+            pool_destroy(pool);
+            return -1;
+        }
+        if (pin) pin_worker(&pool->workers[i]);
+    }
+    return 0;
+}
+
+// run task on every worker, worker i gets args + i * stride
+void pool_run(pi_pool* pool, void* (*task)(void*), void* args, size_t stride) {
+    pthread_mutex_lock(&pool->lock);
+    pool->task = task;
+    pool->args = (char*) args;
+    pool->stride = stride;
+    pool->running = pool->nThreads;
+    pool->generation++;
+    pthread_cond_broadcast(&pool->start);
+    while (pool->running > 0) {
+        pthread_cond_wait(&pool->done, &pool->lock);
+    }
+    pthread_mutex_unlock(&pool->lock);
+}
+
+// wake the workers to exit and join them
+void pool_destroy(pi_pool* pool) {
+    pthread_mutex_lock(&pool->lock);
+    pool->stop = 1;
+    pthread_cond_broadcast(&pool->start);
+    pthread_mutex_unlock(&pool->lock);
+
+    for(int i = 0; i < pool->nThreads; i++) {
+        pthread_join(pool->workers[i].th, NULL);
+    }
+    free(pool->workers);
+    pthread_mutex_destroy(&pool->lock);
+    pthread_cond_destroy(&pool->start);
+    pthread_cond_destroy(&pool->done);
+}
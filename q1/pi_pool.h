@@ -0,0 +1,35 @@
+#ifndef PI_POOL_H
+#define PI_POOL_H
+
+#include <pthread.h>
+#include <stddef.h>
+
+// Workers created once and parked on a condition variable between jobs. A job
+// runs task(args + id * stride) on every worker and returns once all are done.
+typedef struct pi_pool pi_pool;
+
+typedef struct {
+    pi_pool* pool;
+    int id;
+    pthread_t th;
+} pool_worker;
+
+struct pi_pool {
+    int nThreads;
+    pool_worker* workers;
+    pthread_mutex_t lock;
+    pthread_cond_t start;       // workers wait here for the next job
+    pthread_cond_t done;        // pool_run waits here for the job to finish
+    unsigned long generation;   // bumped once per job
+    int running;                // workers still busy with the current job
+    int stop;
+    void* (*task)(void*);
+    char* args;
+    size_t stride;
+};
+
+int pool_init(pi_pool* pool, int nThreads, int pin);
+void pool_run(pi_pool* pool, void* (*task)(void*), void* args, size_t stride);
+void pool_destroy(pi_pool* pool);
+
+#endif /*PI_POOL_H*/
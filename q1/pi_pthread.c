@@ -1,30 +1,56 @@
 #include <stdlib.h>
 #include <stdint.h>
 #include <stdio.h>
+#include <string.h>
+#include <math.h>
 #include <pthread.h>
 #include <time.h>
 #include <unistd.h>
 #include "pi_pthread.h"
-
-// Monte Carlo Variables
-double num_circle = 0.0;
-double num_square = 0.0;
-pthread_mutex_t circle_lock = PTHREAD_MUTEX_INITIALIZER;
-pthread_mutex_t square_lock = PTHREAD_MUTEX_INITIALIZER;
-int max_size = 0;
-
-// thread local random seed
-__thread unsigned int thread_seed;
-
-// Liebniz Variables
-double sum = 0.0;
-pthread_mutex_t sum_lock = PTHREAD_MUTEX_INITIALIZER;
-
+#include "pi_rng.h"
+#include "pi_simd.h"
+#include "pi_pool.h"
+#include "pi_sched.h"
+#include "pi_sum.h"
+#include "pi_series.h"
+#include "pi_chud.h"
+#include "pi_stats.h"
+#include "pi_args.h"
+
+// every run draws from one reproducible sequence picked by the generator and seed
+rng_kind rng_type = RNG_PHILOX;
+uint64_t rng_seed = 1;
+simd_level simd = SIMD_SCALAR;
+
+// chunk size of the scheduler, 0 picks one from the size and thread count
+uint64_t sched_chunk = 0;
+int sched_verbose = 0;
+
+// how the Liebniz terms are added, and whether the result may depend on the
+// split (0) or is reduced from fixed blocks in a fixed order (1)
+sum_mode sum_type = SUM_NAIVE;
+int sum_fixed = 0;
+
+// file the Chudnovsky digits are written to, none when NULL
+const char* digits_file = NULL;
+
+// adaptive Monte-Carlo: stop once the half width of the confidence interval
+// at mc_level is at most mc_tolerance, off when mc_tolerance is 0
+double mc_tolerance = 0.0;
+double mc_level = 0.95;
+
+// what a worker needs for one run of either method
 typedef struct {
-    int lower;
-    int upper;
-    pthread_t th;
-} liebniz_info;
+    pi_sched* sched;
+    int id;
+    pi_slot* slot;
+    double* blocks;     // block sums of the deterministic Liebniz reduction
+    uint64_t size;      // terms of the Liebniz run
+    series_method method;
+    char* digits;       // hex digits of the BBP digit extraction
+    uint64_t position;  // position of digits[0]
+    uint64_t base;      // first Monte-Carlo sample of the round
+} worker_info;
 
 // initialize clock
 double CLOCK() {
@@ -33,100 +59,181 @@ double CLOCK() {
     return (t.tv_sec * 1000) + (t.tv_nsec*1e-6);
 }
 
-// initialize the random number generator for each thread
-void intialize_thread_seed() {
-    thread_seed = time(NULL) ^ pthread_self(); 
+// merge the n slots into slots[0] in pairs of growing distance, log2(n) steps
+// and always the same order of additions
+void reduce_slots(pi_slot* slots, int n) {
+    for(int step = 1; step < n; step *= 2) {
+        for(int i = 0; i + step < n; i += 2 * step) {
+            slots[i].hits += slots[i + step].hits;
+            slots[i].sum += slots[i + step].sum;
+        }
+    }
+}
+
+// cache line aligned slots for n threads, zeroed
+static pi_slot* alloc_slots(int n) {
+    pi_slot* slots = aligned_alloc(CACHE_LINE, n * sizeof(pi_slot));
+    if (slots == NULL) {
+        fprintf(stderr, "Out of memory for %d threads\n", n);
+        exit(EXIT_FAILURE);
+    }
+    memset(slots, 0, n * sizeof(pi_slot));
+    return slots;
+}
+
+// chunk size for size samples, from -c or picked automatically
+static uint64_t pick_chunk(uint64_t size, int nThreads, uint64_t max_chunk) {
+    uint64_t chunk = sched_chunk ? sched_chunk : sched_auto_chunk(size, nThreads, max_chunk);
+    return chunk > max_chunk ? max_chunk : chunk;
 }
 
-// returns a random number from 0 to RAND_MAX
-int get_rand() {
-    return rand_r(&thread_seed);
+// set up the scheduler over [0, size) and slots of a run and the worker arguments
+static pi_slot* start_run(pi_sched* sched, worker_info* info, int nThreads, uint64_t size, uint64_t chunk) {
+    pi_slot* slots = alloc_slots(nThreads);
+    if (sched_init(sched, nThreads, size, chunk) != 0) {
+        fprintf(stderr, "Out of memory for %d threads\n", nThreads);
+        exit(EXIT_FAILURE);
+    }
+    for(int i = 0; i < nThreads; i++) {
+        info[i].sched = sched;
+        info[i].id = i;
+        info[i].slot = &slots[i];
+        info[i].blocks = NULL;
+        info[i].size = size;
+        info[i].base = 0;
+    }
+    return slots;
 }
 
 // monte-carlo thread method
 void *monte_carlo_thread(void* args) {
-    // receive size information for each thread
-    int workload = *((int*) args);
+    worker_info* worker = (worker_info*) args;
 
     // keep track of local circle
-    int local_num_circle = 0;
-
-    // initialize thread seed
-    intialize_thread_seed(); 
-    
-    // loop through the divided workload amount
-    for(int i = 0; i < workload; i++) {
-        // // acquire lock for square
-        // pthread_mutex_lock(&square_lock);
+    uint64_t local_num_circle = 0;
+
+    // sample i uses doubles 2i and 2i + 1 of the sequence, so the hits do not
+    // depend on the number of threads or on who runs which chunk. Philox points
+    // are made and counted in vector registers, xoshiro points are drawn in
+    // batches and counted after.
+    rng_stream rng;
+    rng.index = UINT64_MAX;
+    double points[2 * MC_BATCH];
+    uint64_t first, count;
+    while (sched_next(worker->sched, worker->id, &first, &count)) {
+        first += worker->base;
+        if (rng_type == RNG_PHILOX) {
+            local_num_circle += pi_simd.count_philox(rng_seed, first, (long) count);
+            continue;
+        }
 
-        // // increment square safely in mutex lock
-        // num_square++;
+        // chunks of the own range follow each other, only a steal needs a seek
+        if (rng.index != 2 * first) {
+            rng_seek(&rng, rng_type, rng_seed, 2 * first);
+        }
+        for(uint64_t done = 0; done < count; done += MC_BATCH) {
+            int n = (count - done < MC_BATCH) ? (int) (count - done) : MC_BATCH;
+            rng_fill(&rng, points, 2 * n);
+            local_num_circle += pi_simd.count_points(points, n);
+        }
+    }
 
-        // // return lock for square
-        // pthread_mutex_unlock(&square_lock);
+    // add the count to this thread's own slot, it keeps a running total over
+    // the rounds of an adaptive run
+    worker->slot->hits += local_num_circle;
 
-        // get random number
-        double x = (double)(get_rand() % (max_size + 1)) / max_size;
-        double y = (double)(get_rand() % (max_size + 1)) / max_size;
+    return NULL;
+}
 
-        // calculate the distance
-        double d = x * x + y * y;
+// Adaptive Monte Carlo: rounds of samples [n, n + round) until the confidence
+// interval is narrow enough or size samples are used. The rounds only depend
+// on the hit counts, so the stop is the same for any number of threads.
+static int monte_carlo_adaptive(pi_pool* pool, uint64_t size) {
+    int nThreads = pool->nThreads;
+    double z = normal_quantile(mc_level);
+    printf("------ Adaptive Monte Carlo Simulation ------\n");
+    printf("Number of Threads: %d\n", nThreads);
+    printf("Max Sample size: %llu\n", (unsigned long long) size);
+    printf("Target: +/- %g at %g%% confidence (z = %0.4f)\n", mc_tolerance, 100.0 * mc_level, z);
+    printf("Generator: %s (seed %llu), kernels: %s\n", rng_name(rng_type), (unsigned long long) rng_seed, simd_name(simd));
+
+    worker_info pi_threads[nThreads];
+    pi_slot* slots = alloc_slots(nThreads);
+    uint64_t n = 0, num_circle = 0;
+    int rounds = 0;
+
+    double t1 = CLOCK();
+    while (n < size && !(n > 0 && z * mc_std_error(num_circle, n) <= mc_tolerance)) {
+        uint64_t round = mc_next_round(num_circle, n, z, mc_tolerance, size - n);
+
+        pi_sched sched;
+        if (sched_init(&sched, nThreads, round, pick_chunk(round, nThreads, MC_CHUNK)) != 0) {
+            fprintf(stderr, "Out of memory for %d threads\n", nThreads);
+            exit(EXIT_FAILURE);
+        }
+        for(int i = 0; i < nThreads; i++) {
+            pi_threads[i].sched = &sched;
+            pi_threads[i].id = i;
+            pi_threads[i].slot = &slots[i];
+            pi_threads[i].base = n;
+        }
+        pool_run(pool, monte_carlo_thread, pi_threads, sizeof(worker_info));
+        sched_destroy(&sched);
 
-        // check if it's within the circle
-        if (d <= 1.0) {
-            local_num_circle++;
+        // the running totals of the threads
+        num_circle = 0;
+        for(int i = 0; i < nThreads; i++) {
+            num_circle += slots[i].hits;
         }
+        n += round;
+        rounds++;
     }
+    double total = CLOCK() - t1;
 
-    // update number of points after workload
-    pthread_mutex_lock(&circle_lock);
-    num_circle += local_num_circle;
-    // printf("Num. of Circle in Thread %ld: %0.2f\n", pthread_self(), num_circle);
-    pthread_mutex_unlock(&circle_lock);
-    
-    return NULL;
+    double pi = 4.0 * ((double) num_circle / (double) n);
+    double err = mc_std_error(num_circle, n);
+
+    // print result
+    printf("------ Monte Carlo Result ------\n");
+    printf("Time Elapsed: %0.3f ms\n", total);
+    printf("Samples Used: %llu in %d rounds\n", (unsigned long long) n, rounds);
+    printf("Points in Circle: %llu\n", (unsigned long long) num_circle);
+    printf("Estimation of Pi: %0.9lf +/- %0.3e\n", pi, z * err);
+    printf("Standard Error: %0.3e\n", err);
+    printf("Target Reached: %s\n", z * err <= mc_tolerance ? "yes" : "no, out of samples");
+
+    free(slots);
+    return 0;
 }
 
 // Monte Carlo Execution method
-int monte_carlo_pi(int nThreads, int size) {
+int monte_carlo_pi(pi_pool* pool, uint64_t size) {
+    if (mc_tolerance > 0.0) {
+        return monte_carlo_adaptive(pool, size);
+    }
+    int nThreads = pool->nThreads;
     printf("------ Monte Carlo Simulation ------\n");
     printf("Number of Threads: %d\n", nThreads);
-    printf("Sample size: %d\n", size);
-    // reset global variables
-    max_size = size;
-    num_circle = 0;
-    num_square = 0;
-
+    printf("Sample size: %llu\n", (unsigned long long) size);
+    printf("Generator: %s (seed %llu), kernels: %s\n", rng_name(rng_type), (unsigned long long) rng_seed, simd_name(simd));
     // create benchmark variables 
     double t1, t2, total;
 
-    // split size work for each thread
-    int workloads[nThreads];
-    int base_workload = size / nThreads;
-    int extra = size % nThreads;
-
-    // Distribute work load
-    for (int i = 0; i < nThreads; i++) {
-        workloads[i] = base_workload + (i < extra ? 1 : 0);
-    }
+    // every thread starts on its own block of samples, chunks of the
+    // kernel-sized MC_CHUNK at most
+    pi_sched sched;
+    worker_info pi_threads[nThreads];
+    pi_slot* slots = start_run(&sched, pi_threads, nThreads, size, pick_chunk(size, nThreads, MC_CHUNK));
 
     // start the clock
     t1 = CLOCK();
 
-    // create pthreads
-    pthread_t pi_threads[nThreads];
+    // hand the work to the workers and wait for all of them to finish
+    pool_run(pool, monte_carlo_thread, pi_threads, sizeof(worker_info));
 
-    // spawn the pthreads
-    for(int i = 0; i < nThreads; i++) {
-        pthread_create(&pi_threads[i], NULL, monte_carlo_thread, &workloads[i]);
-    }
-
-    // wait for all threads to finish
-    for(int i = 0; i < nThreads; i++) {
-        pthread_join(pi_threads[i], NULL);
-    }
-
-    // calculate the result of the pi
+    // merge the per-thread counts and calculate the result of the pi
+    reduce_slots(slots, nThreads);
+    uint64_t num_circle = slots[0].hits;
     double pi = 4.0 * ((double) num_circle / (double) size);
 
     // stop the clock & find total time it took to finish
@@ -136,50 +243,77 @@ int monte_carlo_pi(int nThreads, int size) {
     // print result
     printf("------ Monte Carlo Result ------\n");
     printf("Time Elapsed: %0.3f ms\n", total);
-    printf("Points in Circle: %d\n", (int) (num_circle));
-    //printf("Points in Square: %d\n", (int) (num_square));
+    sched_report(&sched, sched_verbose);
+    printf("Points in Circle: %llu\n", (unsigned long long) num_circle);
     printf("Estimation of Pi: %lf\n", pi);
 
+    sched_destroy(&sched);
+    free(slots);
     return 0;
 }
 
-double liebniz_sum(int i) {
-    return (i % 2 == 0) ? (1.0 / (double) (2 * i + 1)) : (-1.0 / (double) (2 * i + 1));
-}
 // Liebniz Thread Method
 void *liebniz_thread(void* args) {
-    // receive size information for each thread
-    liebniz_info* workload = (liebniz_info *) args;
-    int lower = workload->lower;
-    int upper = workload->upper;
+    worker_info* worker = (worker_info*) args;
+    uint64_t first, count;
+
+    // deterministic: the scheduler hands out block numbers, every block sum
+    // goes to its own entry and the blocks are added up after the join
+    if (worker->blocks) {
+        uint64_t size = worker->size;
+        while (sched_next(worker->sched, worker->id, &first, &count)) {
+            for(uint64_t b = first; b < first + count; b++) {
+                uint64_t lower = b * SUM_BLOCK;
+                uint64_t n = size - lower < SUM_BLOCK ? size - lower : SUM_BLOCK;
+                worker->blocks[b] = liebniz_range(sum_type, lower, n);
+            }
+        }
+        return NULL;
+    }
 
     // keep track of local sum
-    double local_sum = 0.0;
+    sum_acc local_sum = { 0.0, 0.0 };
 
-    // traverse through lower and upper bound
-    for (int i = lower; i <= upper; i++) {
-        local_sum += liebniz_sum(i);
+    // add up the terms of every chunk this thread gets
+    while (sched_next(worker->sched, worker->id, &first, &count)) {
+        acc_add(sum_type, &local_sum, liebniz_range(sum_type, first, count));
     }
 
-    pthread_mutex_lock(&sum_lock);
-    sum += local_sum;
-    pthread_mutex_unlock(&sum_lock);
+    worker->slot->sum = acc_value(&local_sum);
 
     return NULL;
 }
 
 // Liebniz Execution Method
-int liebniz_pi(int nThreads, int size) {
+int liebniz_pi(pi_pool* pool, uint64_t size) {
+    int nThreads = pool->nThreads;
     printf("------ Liebniz Formula ------\n");
     printf("Number of Threads: %d\n", nThreads);
-    printf("Sample size: %d\n", size);
-
-    // create pthreads
-    liebniz_info pi_threads[nThreads];
-
-    int base_workload = size / nThreads;
-    int extra = size % nThreads;
-    int count = 0;
+    printf("Sample size: %llu\n", (unsigned long long) size);
+    printf("Summation: %s%s\n", sum_name(sum_type), sum_fixed ? ", deterministic" : "");
+
+    // every thread starts on its own block of terms, or of SUM_BLOCK sized
+    // blocks in the deterministic mode
+    pi_sched sched;
+    worker_info pi_threads[nThreads];
+    pi_slot* slots;
+    double* blocks = NULL;
+    uint64_t nblocks = (size + SUM_BLOCK - 1) / SUM_BLOCK;
+    if (sum_fixed) {
+        uint64_t chunk = sched_chunk ? sched_chunk / SUM_BLOCK : nblocks / ((uint64_t) nThreads * SCHED_CHUNKS_PER_THREAD);
+        blocks = malloc(nblocks * sizeof(double));
+        if (blocks == NULL) {
+            fprintf(stderr, "Out of memory for %llu blocks\n", (unsigned long long) nblocks);
+            exit(EXIT_FAILURE);
+        }
+        slots = start_run(&sched, pi_threads, nThreads, nblocks, chunk > 0 ? chunk : 1);
+        for(int i = 0; i < nThreads; i++) {
+            pi_threads[i].blocks = blocks;
+            pi_threads[i].size = size;
+        }
+    } else {
+        slots = start_run(&sched, pi_threads, nThreads, size, pick_chunk(size, nThreads, UINT64_MAX));
+    }
 
     // create benchmark variables 
     double t1, t2, total;
@@ -187,20 +321,17 @@ int liebniz_pi(int nThreads, int size) {
     // start the clock
     t1 = CLOCK();
 
-    // spawn the pthreads
-    for(int i = 0; i < nThreads; i++) {
-        pi_threads[i].lower = count;
-        count += (base_workload + (i < extra ? 1 : 0));
-        pi_threads[i].upper = count - 1;
-        pthread_create(&pi_threads[i].th, NULL, liebniz_thread, &pi_threads[i]);
-    }
+    // hand the work to the workers and wait for all of them to finish
+    pool_run(pool, liebniz_thread, pi_threads, sizeof(worker_info));
 
-    // wait for all threads to finish
-    for(int i = 0; i < nThreads; i++) {
-        pthread_join(pi_threads[i].th, NULL);
+    // merge the partial sums and calculate pi
+    double sum;
+    if (sum_fixed) {
+        sum = sum_tree(blocks, nblocks);
+    } else {
+        reduce_slots(slots, nThreads);
+        sum = slots[0].sum;
     }
-
-    // calculate pi
     double pi = 4.0 * sum;
 
     // stop the clock
@@ -210,26 +341,352 @@ int liebniz_pi(int nThreads, int size) {
     // print result
     printf("------ Liebniz Result ------\n");
     printf("Time Elapsed: %0.3f ms\n", total);
+    sched_report(&sched, sched_verbose);
     printf("Liebniz Sum: %lf\n", sum);
     printf("Estimation of Pi: %0.12lf\n", pi);
+    printf("Error: %0.3e\n", fabs(pi - PI_REFERENCE));
+
+    sched_destroy(&sched);
+    free(blocks);
+    free(slots);
+    return 0;
+}
+
+// Series Thread Method
+void *series_thread(void* args) {
+    worker_info* worker = (worker_info*) args;
+    double local_sum = 0.0;
+
+    uint64_t first, count;
+    while (sched_next(worker->sched, worker->id, &first, &count)) {
+        local_sum += series_range(worker->method, first, count);
+    }
+
+    worker->slot->sum = local_sum;
+
+    return NULL;
+}
+
+// Euler, Machin or BBP Execution Method
+int series_pi(pi_pool* pool, series_method method, uint64_t size) {
+    int nThreads = pool->nThreads;
+    printf("------ %s ------\n", series_name(method));
+    printf("Number of Threads: %d\n", nThreads);
+
+    // the terms past the double range add nothing, do not hand them out
+    uint64_t terms = series_terms(method, size);
+    uint64_t chunk = sched_chunk ? sched_chunk : (terms + nThreads - 1) / nThreads;
+    pi_sched sched;
+    worker_info pi_threads[nThreads];
+    pi_slot* slots = start_run(&sched, pi_threads, nThreads, terms, chunk);
+    for(int i = 0; i < nThreads; i++) {
+        pi_threads[i].method = method;
+    }
+
+    // create benchmark variables
+    double t1, t2, total;
+    t1 = CLOCK();
+
+    pool_run(pool, series_thread, pi_threads, sizeof(worker_info));
+
+    // merge the partial sums
+    reduce_slots(slots, nThreads);
+    double pi = slots[0].sum;
+
+    t2 = CLOCK();
+    total = t2 - t1;
+
+    // print result
+    printf("------ %s Result ------\n", series_name(method));
+    printf("Time Elapsed: %0.3f ms\n", total);
+    sched_report(&sched, sched_verbose);
+    printf("Terms: %llu\n", (unsigned long long) terms);
+    printf("Estimation of Pi: %0.15lf\n", pi);
+    printf("Error: %0.3e\n", fabs(pi - PI_REFERENCE));
+
+    sched_destroy(&sched);
+    free(slots);
+    return 0;
+}
+
+// BBP digit thread method, one hex digit per scheduled position
+void *bbp_digits_thread(void* args) {
+    worker_info* worker = (worker_info*) args;
+
+    uint64_t first, count;
+    while (sched_next(worker->sched, worker->id, &first, &count)) {
+        for(uint64_t i = first; i < first + count; i++) {
+            worker->digits[i] = "0123456789ABCDEF"[bbp_hex_digit(worker->position + i)];
+        }
+    }
+
+    return NULL;
+}
 
-    
+// hex digits [position, position + n) of pi, each computed on its own
+int bbp_digits_pi(pi_pool* pool, uint64_t position, uint64_t n) {
+    int nThreads = pool->nThreads;
+    printf("------ BBP Digit Extraction ------\n");
+    printf("Number of Threads: %d\n", nThreads);
+    printf("Position: %llu, Digits: %llu\n", (unsigned long long) position, (unsigned long long) n);
+
+    char* digits = malloc(n + 1);
+    if (digits == NULL) {
+        fprintf(stderr, "Out of memory for %llu digits\n", (unsigned long long) n);
+        exit(EXIT_FAILURE);
+    }
+    digits[n] = '\0';
+
+    // the cost of a digit grows with its position, so one digit per chunk
+    // and the scheduler evens it out
+    pi_sched sched;
+    worker_info pi_threads[nThreads];
+    pi_slot* slots = start_run(&sched, pi_threads, nThreads, n, 1);
+    for(int i = 0; i < nThreads; i++) {
+        pi_threads[i].digits = digits;
+        pi_threads[i].position = position;
+    }
+
+    double t1 = CLOCK();
+    pool_run(pool, bbp_digits_thread, pi_threads, sizeof(worker_info));
+    double total = CLOCK() - t1;
+
+    printf("------ BBP Digit Extraction Result ------\n");
+    printf("Time Elapsed: %0.3f ms\n", total);
+    sched_report(&sched, sched_verbose);
+    printf("Hex Digits: %s\n", digits);
+
+    sched_destroy(&sched);
+    free(slots);
+    free(digits);
     return 0;
 }
 
+// what a worker needs for the Chudnovsky splitting and merges
+typedef struct {
+    chud_part* parts;   // one part per thread, merged into parts[0]
+    bigint (*prod)[4];  // products of the merges of one level
+    int nparts;
+    int nworkers;
+    int id;
+    int step;           // distance of the parts merged in this level
+    uint64_t terms;
+} chud_info;
+
+// merges in the level of parts step apart
+static int merge_pairs(int nparts, int step) {
+    return (nparts - step + 2 * step - 1) / (2 * step);
+}
+
+// Chudnovsky split thread method, binary splitting of one block of terms
+void *chud_split_thread(void* args) {
+    chud_info* info = (chud_info*) args;
+    if (info->id >= info->nparts) return NULL;
+
+    uint64_t n = info->nparts;
+    uint64_t id = info->id;
+    uint64_t a = id * (info->terms / n) + (id < info->terms % n ? id : info->terms % n);
+    uint64_t count = info->terms / n + (id < info->terms % n ? 1 : 0);
+
+    // the last block is never on the left of a merge and needs no P
+    chud_split(&info->parts[id], a, a + count, info->id != info->nparts - 1);
+
+    return NULL;
+}
+
+// Chudnovsky merge thread method; every merge of a level takes four
+// products, the workers take them in turns so even the last merge runs on
+// four threads
+void *chud_merge_thread(void* args) {
+    chud_info* info = (chud_info*) args;
+    int step = info->step;
+    int npairs = merge_pairs(info->nparts, step);
+
+    for(int job = info->id; job < 4 * npairs; job += info->nworkers) {
+        int pair = job / 4;
+        chud_product k = (chud_product) (job % 4);
+        int left = 2 * step * pair;
+        int need_p = left + 2 * step < info->nparts;
+        if (k == CHUD_PP && !need_p) continue;
+        chud_multiply(&info->prod[pair][k], k, &info->parts[left], &info->parts[left + step]);
+    }
+
+    return NULL;
+}
+
+// Chudnovsky Execution Method, digits of pi after the point written to file
+int chudnovsky_pi(pi_pool* pool, uint64_t digits) {
+    int nThreads = pool->nThreads;
+    uint64_t terms = chud_terms(digits);
+    size_t limbs = chud_limbs(digits);
+    printf("------ Chudnovsky Binary Splitting ------\n");
+    printf("Number of Threads: %d\n", nThreads);
+    printf("Digits: %llu\n", (unsigned long long) digits);
+    printf("Terms: %llu\n", (unsigned long long) terms);
+
+    // fewer parts than threads when there are only a few terms
+    int nparts = (uint64_t) nThreads < terms ? nThreads : (int) terms;
+    chud_part* parts = malloc(nparts * sizeof(chud_part));
+    bigint (*prod)[4] = malloc(((nparts + 1) / 2) * sizeof(*prod));
+    chud_info info[nThreads];
+    if (parts == NULL || prod == NULL) {
+        fprintf(stderr, "Out of memory for %d threads\n", nThreads);
+        exit(EXIT_FAILURE);
+    }
+    for(int i = 0; i < nparts; i++) {
+        chud_init(&parts[i]);
+    }
+    for(int i = 0; i < nThreads; i++) {
+        info[i].parts = parts;
+        info[i].prod = prod;
+        info[i].nparts = nparts;
+        info[i].nworkers = nThreads;
+        info[i].id = i;
+        info[i].step = 0;
+        info[i].terms = terms;
+    }
+
+    double t1, t2, t3, total;
+    t1 = CLOCK();
+
+    // every worker splits its own block of terms, without sharing anything
+    pool_run(pool, chud_split_thread, info, sizeof(chud_info));
+
+    // merge the blocks pairwise, a level at a time
+    for(int step = 1; step < nparts; step *= 2) {
+        int npairs = merge_pairs(nparts, step);
+        for(int p = 0; p < npairs; p++) {
+            for(int k = 0; k < 4; k++) {
+                big_init(&prod[p][k]);
+            }
+        }
+        for(int i = 0; i < nThreads; i++) {
+            info[i].step = step;
+        }
+        pool_run(pool, chud_merge_thread, info, sizeof(chud_info));
+        for(int p = 0; p < npairs; p++) {
+            int left = 2 * step * p;
+            chud_combine(&parts[left], prod[p], left + 2 * step < nparts);
+            chud_free(&parts[left + step]);
+            for(int k = 0; k < 4; k++) {
+                big_free(&prod[p][k]);
+            }
+        }
+    }
+    t2 = CLOCK();
+
+    // pi = 426880 sqrt(10005) Q / T by Newton iterations
+    bigint y, pi;
+    big_init(&y);
+    big_init(&pi);
+    chud_inv_sqrt(&y, limbs);
+    chud_pi(&pi, &parts[0], &y, limbs);
+    t3 = CLOCK();
+    total = t3 - t1;
+
+    // print result
+    printf("------ Chudnovsky Result ------\n");
+    printf("Time Elapsed: %0.3f ms (splitting %0.3f ms, division %0.3f ms)\n", total, t2 - t1, t3 - t2);
+    printf("First Digits: 3.");
+    chud_digits(&pi, limbs, 0, digits < 50 ? digits : 50, stdout);
+    printf("\n");
+    if (digits > 50) {
+        printf("Last Digits: ...");
+        chud_digits(&pi, limbs, digits - 20, 20, stdout);
+        printf("\n");
+    }
+
+    int res = 0;
+    if (digits_file) {
+        // streamed a limb at a time, the digits are never held as text
+        FILE* fp = fopen(digits_file, "w");
+        if (fp == NULL) {
+            fprintf(stderr, "Could not open %s\n", digits_file);
+            res = 1;
+        } else {
+            fprintf(fp, "3.");
+            chud_digits(&pi, limbs, 0, digits, fp);
+            fprintf(fp, "\n");
+            fclose(fp);
+            printf("Digits written to %s\n", digits_file);
+        }
+    }
+
+    chud_free(&parts[0]);
+    big_free(&y);
+    big_free(&pi);
+    free(parts);
+    free(prod);
+    return res;
+}
+
+// run method part (0 - 5) on size samples, terms or digits
+int run_method(pi_pool* pool, int part, uint64_t size) {
+    switch (part) {
+        case 0:  return monte_carlo_pi(pool, size);
+        case 1:  return liebniz_pi(pool, size);
+        case PI_CHUDNOVSKY: return chudnovsky_pi(pool, size);
+        default: return series_pi(pool, (series_method) part, size);
+    }
+}
+
+// Run every job of file through the pool, one per line as
+// "method size [seed]"; blank lines and lines starting with # are skipped.
+int run_batch(pi_pool* pool, const char* file) {
+    FILE* fp = fopen(file, "r");
+    if (fp == NULL) {
+        fprintf(stderr, "Could not open batch file %s\n", file);
+        return 1;
+    }
+
+    char line[256];
+    int lineno = 0;
+    int job = 0;
+    int res = 0;
+    uint64_t default_seed = rng_seed;
+    while (fgets(line, sizeof(line), fp) != NULL) {
+        lineno++;
+        char method[32], size[64], seed[32];
+        int n = sscanf(line, "%31s %63s %31s", method, size, seed);
+        if (n <= 0 || method[0] == '#') continue;
+
+        uint64_t job_size;
+        if (n < 2 || method[1] != '\0' || method[0] < '0' || method[0] > '5' || parse_size(size, &job_size) != 0) {
+            fprintf(stderr, "%s:%d: expected \"method size [seed]\"\n", file, lineno);
+            res = 1;
+            continue;
+        }
+        rng_seed = (n == 3) ? strtoull(seed, NULL, 10) : default_seed;
+
+        printf("====== Job %d ======\n", ++job);
+        res |= run_method(pool, method[0] - '0', job_size);
+    }
+    rng_seed = default_seed;
+    fclose(fp);
+    return res;
+}
+
 int main(int argc, char** argv) {
     int opt; 
     int numThreads = 16;        // default num of threads
     int part = 0;               // 0 - indicates approximation using monte-carlo method
                                 // 1 - indicates approximation using Leibniz's method
-    int sample_size = 100000;   // default sample size
+                                // 2 - 4 the Euler, Machin and BBP series
+                                // 5 - digits with Chudnovsky binary splitting
+    uint64_t sample_size = 100000;  // default sample size
+    const char* batch_file = NULL;  // list of jobs to run instead of one
+    int pin = 0;                    // pin the workers to cores
+    uint64_t hex_position = 0;      // BBP digit extraction from this position
+    uint64_t hex_digits = 8;        // number of hex digits to extract
+    simd = simd_detect();
+
     // get user arguments
-    while((opt = getopt(argc, argv, "p:t:s:h")) != -1) {
+    while((opt = getopt(argc, argv, "p:t:s:r:g:k:b:ac:vm:dx:n:o:e:l:h")) != -1) {
         int temp;
         switch (opt) {
             case 'p':
                 temp = atoi(optarg);
-                if (temp >= 2 || temp < 0) {
+                if (temp > PI_CHUDNOVSKY || temp < 0) {
                     printf("Invalid Input for Pi Approximation Method. Using Monte-Carlo as default method.\n");
                     break;
                 } else { 
@@ -237,12 +694,63 @@ int main(int argc, char** argv) {
                 }
                 break;
             case 's':
-                temp = atoi(optarg);
-                if (temp <= 0) {
-                    printf("Invalid input for sample size. Using default: %d\n", sample_size);
-                    break;
-                } else {
-                    sample_size = temp;
+                if (parse_size(optarg, &sample_size) != 0) {
+                    printf("Invalid input for sample size. Using default: %llu\n", (unsigned long long) sample_size);
+                }
+                break;
+            case 'b':
+                batch_file = optarg;
+                break;
+            case 'a':
+                pin = 1;
+                break;
+            case 'c':
+                if (strcmp(optarg, "auto") == 0) {
+                    sched_chunk = 0;
+                } else if (parse_size(optarg, &sched_chunk) != 0) {
+                    printf("Invalid input for chunk size. Using default: auto\n");
+                    sched_chunk = 0;
+                }
+                break;
+            case 'v':
+                sched_verbose = 1;
+                break;
+            case 'm':
+                if (parse_sum(optarg, &sum_type) != 0) {
+                    printf("Invalid input for summation. Using default: naive\n");
+                    sum_type = SUM_NAIVE;
+                }
+                break;
+            case 'd':
+                sum_fixed = 1;
+                break;
+            case 'x':
+                if (parse_size(optarg, &hex_position) != 0) {
+                    printf("Invalid input for hex digit position.\n");
+                    hex_position = 0;
+                }
+                break;
+            case 'o':
+                digits_file = optarg;
+                break;
+            case 'e':
+                mc_tolerance = atof(optarg);
+                if (mc_tolerance <= 0.0) {
+                    printf("Invalid input for tolerance. Running the full sample size.\n");
+                    mc_tolerance = 0.0;
+                }
+                break;
+            case 'l':
+                mc_level = atof(optarg);
+                if (mc_level <= 0.0 || mc_level >= 1.0) {
+                    printf("Invalid input for confidence level. Using default: 0.95\n");
+                    mc_level = 0.95;
+                }
+                break;
+            case 'n':
+                if (parse_size(optarg, &hex_digits) != 0) {
+                    printf("Invalid input for number of hex digits. Using default: 8\n");
+                    hex_digits = 8;
                 }
                 break;
             case 't':
@@ -253,31 +761,69 @@ int main(int argc, char** argv) {
                     numThreads = temp;
                 }
                 break;
+            case 'r':
+                rng_seed = strtoull(optarg, NULL, 10);
+                break;
+            case 'g':
+                if (parse_rng(optarg, &rng_type) != 0) {
+                    printf("Invalid input for random generator. Using default: philox\n");
+                    rng_type = RNG_PHILOX;
+                }
+                break;
+            case 'k':
+                if (parse_simd(optarg, &simd) != 0) {
+                    printf("Invalid input for kernels. Using default: auto\n");
+                    simd = simd_detect();
+                }
+                break;
             case 'h':
-                printf("Usage: %s [-s size] [-t threads] [-h]\n", argv[0]);
+                printf("Usage: %s [-p method] [-s size] [-t threads] [-r seed] [-g generator] [-k kernels] [-b file] [-a] [-c chunk] [-v] [-m sum] [-d] [-x pos] [-n digits] [-o file] [-e tol] [-l level] [-h]\n", argv[0]);
                 printf("  -p method   Set the approximation method\n");
-                printf("              (0 -> Monte-Carlo | 1 -> Liebniz)\n");
+                printf("              (0 -> Monte-Carlo | 1 -> Liebniz | 2 -> Euler | 3 -> Machin | 4 -> BBP |\n");
+                printf("               5 -> Chudnovsky, -s digits)\n");
                 printf("  -s size     Set the sample size\n");
                 printf("  -t threads  Set the number of threads\n");
+                printf("  -r seed     Set the Monte-Carlo seed (Default: 1)\n");
+                printf("  -g gen      Set the random generator (philox | xoshiro)\n");
+                printf("  -k kernels  Set the Monte-Carlo kernels (auto | scalar | avx2 | avx512)\n");
+                printf("  -b file     Run the jobs listed in file, one \"method size [seed]\" per line\n");
+                printf("  -a          Pin each worker thread to its own core\n");
+                printf("  -c chunk    Set the samples per scheduled chunk (Default: auto)\n");
+                printf("  -v          Report chunks and steals of every thread\n");
+                printf("  -m sum      Set the Liebniz summation (naive | kahan | pairwise | paired)\n");
+                printf("  -d          Reduce the Liebniz sum in a fixed order, the same for any threads\n");
+                printf("  -x pos      Extract hex digits of pi from position pos with BBP\n");
+                printf("  -n digits   Set the number of hex digits to extract (Default: 8)\n");
+                printf("  -o file     Write the Chudnovsky digits to file\n");
+                printf("  -e tol      Stop the Monte-Carlo run once pi is within tol, -s is the most samples\n");
+                printf("  -l level    Set the confidence level of -e (Default: 0.95)\n");
                 printf("  -h          Display this help message\n");
                 return 0;
             default: /* '?' */
-                fprintf(stderr, "Usage: %s [-p method] [-s size] [-t threads] [-h]\n", argv[0]);
+                fprintf(stderr, "Usage: %s [-p method] [-s size] [-t threads] [-r seed] [-g generator] [-k kernels] [-b file] [-a] [-c chunk] [-v] [-m sum] [-d] [-x pos] [-n digits] [-o file] [-e tol] [-l level] [-h]\n", argv[0]);
                 exit(EXIT_FAILURE);
         }
     }
 
+    // falls back to the best instruction set the cpu has
+    simd = simd_select(simd);
+
+    // the workers are created once and reused by every job
+    pi_pool pool;
+    if (pool_init(&pool, numThreads, pin) != 0) {
+        exit(EXIT_FAILURE);
+    }
+
     int res = 0;
-    if (!part) {
-        res = monte_carlo_pi(numThreads, sample_size);
+    if (batch_file) {
+        res = run_batch(&pool, batch_file);
+    } else if (hex_position) {
+        res = bbp_digits_pi(&pool, hex_position, hex_digits);
     } else {
-        res = liebniz_pi(numThreads, sample_size);
+        res = run_method(&pool, part, sample_size);
     }
 
-    // Clean up procedure
-    pthread_mutex_destroy(&circle_lock);
-    pthread_mutex_destroy(&square_lock);
-    pthread_mutex_destroy(&sum_lock);
-    
+    pool_destroy(&pool);
+
     return res;
 }
\ No newline at end of file
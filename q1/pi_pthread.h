@@ -2,28 +2,48 @@
 #define PI_PTHREAD_H
 
 # include <pthread.h>
+# include <stdint.h>
+# include "pi_pool.h"
+# include "pi_sched.h"
+# include "pi_series.h"
+# include "pi_chud.h"
 
-// Extern declarations of global variables
-// Monte-Carlo
-extern double num_circle;
-extern double num_square;
-extern pthread_mutex_t circle_lock;
-extern pthread_mutex_t square_lock;
+// points drawn per call to the random generator in each thread
+#define MC_BATCH 1024
 
-// Liebniz
-extern double sum;
-extern pthread_mutex_t sum_lock;
+// samples a kernel call handles at most, larger ranges are walked in chunks
+#define MC_CHUNK (1L << 30)
+
+// Result of one thread, alone on its cache line so the threads never write
+// to a shared line. The slots are merged after the join.
+typedef struct {
+    uint64_t hits;      // Monte-Carlo points in the circle
+    double sum;         // Liebniz partial sum
+} __attribute__((aligned(CACHE_LINE))) pi_slot;
 
 // Functions
 double CLOCK();
 
-void intialize_thread_seed();
-int get_rand();
+void reduce_slots(pi_slot* slots, int n);
+
 void *monte_carlo_thread(void* arg);
-int monte_carlo_pi(int nThreads, int size);
+int monte_carlo_pi(pi_pool* pool, uint64_t size);
 
-double liebniz_sum(int i);
 void *liebniz_thread(void* args);
-int liebniz_pi(int nThreads, int size);
+int liebniz_pi(pi_pool* pool, uint64_t size);
+
+void *series_thread(void* args);
+int series_pi(pi_pool* pool, series_method method, uint64_t size);
+
+void *bbp_digits_thread(void* args);
+int bbp_digits_pi(pi_pool* pool, uint64_t position, uint64_t n);
+
+void *chud_split_thread(void* args);
+void *chud_merge_thread(void* args);
+int chudnovsky_pi(pi_pool* pool, uint64_t digits);
+
+int run_method(pi_pool* pool, int part, uint64_t size);
+
+int run_batch(pi_pool* pool, const char* file);
 
 #endif /*PI_PTHREAD_H*/
\ No newline at end of file
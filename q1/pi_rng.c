@@ -0,0 +1,148 @@
+#include <string.h>
+#include "pi_rng.h"
+
+// top 53 bits as a double in [0, 1)
+double rng_to_double(uint64_t x) {
+    return (x >> 11) * (1.0 / 9007199254740992.0);
+}
+
+// 10 rounds of Philox on a 128-bit counter, the seed is the 64-bit key
+void philox4x32(uint64_t counter, uint64_t seed, uint32_t out[4]) {
+    uint32_t c0 = (uint32_t) counter, c1 = (uint32_t) (counter >> 32), c2 = 0, c3 = 0;
+    uint32_t k0 = (uint32_t) seed, k1 = (uint32_t) (seed >> 32);
+    for(int round = 0; round < 10; round++) {
+        uint64_t p0 = (uint64_t) PHILOX_M0 * c0;
+        uint64_t p1 = (uint64_t) PHILOX_M1 * c2;
+        uint32_t n0 = (uint32_t) (p1 >> 32) ^ c1 ^ k0;
+        uint32_t n2 = (uint32_t) (p0 >> 32) ^ c3 ^ k1;
+        c1 = (uint32_t) p1;
+        c3 = (uint32_t) p0;
+        c0 = n0;
+        c2 = n2;
+        k0 += PHILOX_W0;
+        k1 += PHILOX_W1;
+    }
+    out[0] = c0;
+    out[1] = c1;
+    out[2] = c2;
+    out[3] = c3;
+}
+
+static uint64_t rotl(uint64_t x, int k) {
+    return (x << k) | (x >> (64 - k));
+}
+
+static uint64_t xoshiro_next(uint64_t s[4]) {
+    uint64_t result = rotl(s[1] * 5, 7) * 9;
+    uint64_t t = s[1] << 17;
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = rotl(s[3], 45);
+    return result;
+}
+
+// advance the state by 2^128 steps
+static void xoshiro_jump(uint64_t s[4]) {
+    static const uint64_t JUMP[] = { 0x180ec6d33cfd0abaULL, 0xd5a61266f0c9392cULL,
+                                     0xa9582618e03fc9aaULL, 0x39abdc4529b1661cULL };
+    uint64_t t[4] = { 0, 0, 0, 0 };
+    for(int i = 0; i < 4; i++) {
+        for(int b = 0; b < 64; b++) {
+            if (JUMP[i] & (1ULL << b)) {
+                t[0] ^= s[0];
+                t[1] ^= s[1];
+                t[2] ^= s[2];
+                t[3] ^= s[3];
+            }
+            xoshiro_next(s);
+        }
+    }
+    memcpy(s, t, sizeof(t));
+}
+
+// splitmix64, used to spread the seed over the xoshiro state
+static uint64_t splitmix64(uint64_t* x) {
+    uint64_t z = (*x += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+// parse "philox" or "xoshiro", 0 on success
+int parse_rng(const char* s, rng_kind* out) {
+    if (strcmp(s, "philox") == 0) {
+        *out = RNG_PHILOX;
+    } else if (strcmp(s, "xoshiro") == 0) {
+        *out = RNG_XOSHIRO;
+    } else {
+        return -1;
+    }
+    return 0;
+}
+
+const char* rng_name(rng_kind kind) {
+    return kind == RNG_XOSHIRO ? "xoshiro256**" : "philox4x32-10";
+}
+
+// position r at double number index of the sequence for seed
+void rng_seek(rng_stream* r, rng_kind kind, uint64_t seed, uint64_t index) {
+    r->kind = kind;
+    r->seed = seed;
+    r->index = index;
+    if (kind != RNG_XOSHIRO) return;
+
+    uint64_t x = seed;
+    for(int i = 0; i < 4; i++) {
+        r->block[i] = splitmix64(&x);
+    }
+    // one jump per block before the one holding index, then step inside it
+    for(uint64_t b = 0; b < index / RNG_BLOCK; b++) {
+        xoshiro_jump(r->block);
+    }
+    memcpy(r->s, r->block, sizeof(r->s));
+    for(uint64_t i = 0; i < index % RNG_BLOCK; i++) {
+        xoshiro_next(r->s);
+    }
+    r->left = RNG_BLOCK - index % RNG_BLOCK;
+}
+
+// fill out with the next n doubles of the sequence
+void rng_fill(rng_stream* r, double* out, int n) {
+    int k = 0;
+    if (r->kind == RNG_XOSHIRO) {
+        while (k < n) {
+            if (r->left == 0) {
+                xoshiro_jump(r->block);
+                memcpy(r->s, r->block, sizeof(r->s));
+                r->left = RNG_BLOCK;
+            }
+            uint64_t run = (uint64_t) (n - k) < r->left ? (uint64_t) (n - k) : r->left;
+            for(uint64_t i = 0; i < run; i++) {
+                out[k++] = rng_to_double(xoshiro_next(r->s));
+            }
+            r->left -= run;
+        }
+        r->index += n;
+        return;
+    }
+
+    // every Philox call gives two doubles, an odd start uses the second one
+    uint32_t w[4];
+    if ((r->index & 1) && k < n) {
+        philox4x32(r->index >> 1, r->seed, w);
+        out[k++] = rng_to_double(((uint64_t) w[3] << 32) | w[2]);
+    }
+    for(; k + 1 < n; k += 2) {
+        philox4x32((r->index + k) >> 1, r->seed, w);
+        out[k] = rng_to_double(((uint64_t) w[1] << 32) | w[0]);
+        out[k + 1] = rng_to_double(((uint64_t) w[3] << 32) | w[2]);
+    }
+    if (k < n) {
+        philox4x32((r->index + k) >> 1, r->seed, w);
+        out[k++] = rng_to_double(((uint64_t) w[1] << 32) | w[0]);
+    }
+    r->index += n;
+}
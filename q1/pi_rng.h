@@ -0,0 +1,38 @@
+#ifndef PI_RNG_H
+#define PI_RNG_H
+
+#include <stdint.h>
+
+// Both generators turn a seed into one fixed sequence of doubles in [0, 1).
+// A thread seeks to the index of its first sample and fills from there, so the
+// samples (and the hit count) do not depend on how the work is split.
+typedef enum {
+    RNG_PHILOX,     // Philox4x32-10, double j comes from counter j / 2
+    RNG_XOSHIRO     // xoshiro256**, a jump of 2^128 steps per block of RNG_BLOCK doubles
+} rng_kind;
+
+#define RNG_BLOCK (1ULL << 20)
+
+typedef struct {
+    rng_kind kind;
+    uint64_t seed;
+    uint64_t index;     // index of the next double in the sequence
+    uint64_t s[4];      // xoshiro state for the next double
+    uint64_t block[4];  // xoshiro state at the start of the current block
+    uint64_t left;      // doubles left in the current xoshiro block
+} rng_stream;
+
+// Philox4x32-10 constants (Salmon et al., "Parallel random numbers: as easy as 1, 2, 3")
+#define PHILOX_M0 0xD2511F53U
+#define PHILOX_M1 0xCD9E8D57U
+#define PHILOX_W0 0x9E3779B9U
+#define PHILOX_W1 0xBB67AE85U
+
+void philox4x32(uint64_t counter, uint64_t seed, uint32_t out[4]);
+double rng_to_double(uint64_t x);
+int parse_rng(const char* s, rng_kind* out);
+const char* rng_name(rng_kind kind);
+void rng_seek(rng_stream* r, rng_kind kind, uint64_t seed, uint64_t index);
+void rng_fill(rng_stream* r, double* out, int n);
+
+#endif /*PI_RNG_H*/
@@ -0,0 +1,115 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "pi_sched.h"
+
+// about SCHED_CHUNKS_PER_THREAD chunks per thread, within [SCHED_MIN_CHUNK, max_chunk]
+uint64_t sched_auto_chunk(uint64_t size, int nThreads, uint64_t max_chunk) {
+    uint64_t chunk = size / ((uint64_t) nThreads * SCHED_CHUNKS_PER_THREAD);
+    if (chunk < SCHED_MIN_CHUNK) chunk = SCHED_MIN_CHUNK;
+    if (chunk > max_chunk) chunk = max_chunk;
+    return chunk;
+}
+
+// give every thread one contiguous block of [0, size) to start from; 0 on success
+int sched_init(pi_sched* sched, int nThreads, uint64_t size, uint64_t chunk) {
+    sched->nThreads = nThreads;
+    sched->chunk = chunk > 0 ? chunk : 1;
+    sched->q = aligned_alloc(CACHE_LINE, nThreads * sizeof(sched_deque));
+    if (sched->q == NULL) return -1;
+
+    uint64_t base = size / nThreads;
+    uint64_t extra = size % nThreads;
+    uint64_t count = 0;
+    for(int i = 0; i < nThreads; i++) {
+        sched_deque* q = &sched->q[i];
+        pthread_mutex_init(&q->lock, NULL);
+        q->lo = count;
+        count += base + ((uint64_t) i < extra ? 1 : 0);
+        q->hi = count;
+        q->chunks = 0;
+        q->steals = 0;
+        q->samples = 0;
+    }
+    return 0;
+}
+
+// move the back half (in whole chunks, at least one) of victim's range to thief
+static int steal(pi_sched* sched, sched_deque* thief, sched_deque* victim) {
+    pthread_mutex_lock(&victim->lock);
+    uint64_t left = victim->hi - victim->lo;
+    if (left == 0) {
+        pthread_mutex_unlock(&victim->lock);
+        return 0;
+    }
+    uint64_t nchunks = (left + sched->chunk - 1) / sched->chunk;
+    uint64_t keep = nchunks - (nchunks / 2 > 0 ? nchunks / 2 : 1);
+    uint64_t mid = victim->lo + keep * sched->chunk;
+    uint64_t hi = victim->hi;
+    victim->hi = mid;
+    pthread_mutex_unlock(&victim->lock);
+
+    // the thief's own range is empty, nobody else can add to it
+    pthread_mutex_lock(&thief->lock);
+    thief->lo = mid;
+    thief->hi = hi;
+    thief->steals++;
+    pthread_mutex_unlock(&thief->lock);
+    return 1;
+}
+
+// Next chunk [first, first + count) for thread id, stealing when its own
+// range runs out. Returns 0 once no thread has work left.
+int sched_next(pi_sched* sched, int id, uint64_t* first, uint64_t* count) {
+    sched_deque* own = &sched->q[id];
+    for(;;) {
+        pthread_mutex_lock(&own->lock);
+        if (own->lo < own->hi) {
+            uint64_t left = own->hi - own->lo;
+            *first = own->lo;
+            *count = left < sched->chunk ? left : sched->chunk;
+            own->lo += *count;
+            own->chunks++;
+            own->samples += *count;
+            pthread_mutex_unlock(&own->lock);
+            return 1;
+        }
+        pthread_mutex_unlock(&own->lock);
+
+        // look for a victim, starting from the next thread
+        int found = 0;
+        for(int k = 1; k < sched->nThreads && !found; k++) {
+            found = steal(sched, own, &sched->q[(id + k) % sched->nThreads]);
+        }
+        if (!found) return 0;
+    }
+}
+
+// totals, and per thread when verbose, so an imbalance shows up
+void sched_report(const pi_sched* sched, int verbose) {
+    uint64_t chunks = 0, steals = 0;
+    uint64_t min = UINT64_MAX, max = 0;
+    for(int i = 0; i < sched->nThreads; i++) {
+        const sched_deque* q = &sched->q[i];
+        chunks += q->chunks;
+        steals += q->steals;
+        if (q->samples < min) min = q->samples;
+        if (q->samples > max) max = q->samples;
+    }
+    printf("Chunks: %llu (size %llu), Steals: %llu, Samples per Thread: %llu - %llu\n",
+           (unsigned long long) chunks, (unsigned long long) sched->chunk,
+           (unsigned long long) steals, (unsigned long long) min, (unsigned long long) max);
+    if (!verbose) return;
+    for(int i = 0; i < sched->nThreads; i++) {
+        const sched_deque* q = &sched->q[i];
+        printf("  Thread %d: %llu chunks, %llu steals, %llu samples\n", i,
+               (unsigned long long) q->chunks, (unsigned long long) q->steals,
+               (unsigned long long) q->samples);
+    }
+}
+
+void sched_destroy(pi_sched* sched) {
+    for(int i = 0; i < sched->nThreads; i++) {
+        pthread_mutex_destroy(&sched->q[i].lock);
+    }
+    free(sched->q);
+}
@@ -0,0 +1,36 @@
+#ifndef PI_SCHED_H
+#define PI_SCHED_H
+
+#include <pthread.h>
+#include <stdint.h>
+
+#define CACHE_LINE 64
+
+// chunks the auto chunk size aims for per thread, and its lower bound
+#define SCHED_CHUNKS_PER_THREAD 16
+#define SCHED_MIN_CHUNK 4096
+
+// Samples [lo, hi) still owned by one thread. The owner takes chunks from the
+// front, an idle thread steals the back half.
+typedef struct {
+    pthread_mutex_t lock;
+    uint64_t lo;
+    uint64_t hi;
+    uint64_t chunks;    // chunks this thread completed
+    uint64_t steals;    // successful steals by this thread
+    uint64_t samples;   // samples this thread completed
+} __attribute__((aligned(CACHE_LINE))) sched_deque;
+
+typedef struct {
+    int nThreads;
+    uint64_t chunk;
+    sched_deque* q;
+} pi_sched;
+
+uint64_t sched_auto_chunk(uint64_t size, int nThreads, uint64_t max_chunk);
+int sched_init(pi_sched* sched, int nThreads, uint64_t size, uint64_t chunk);
+int sched_next(pi_sched* sched, int id, uint64_t* first, uint64_t* count);
+void sched_report(const pi_sched* sched, int verbose);
+void sched_destroy(pi_sched* sched);
+
+#endif /*PI_SCHED_H*/
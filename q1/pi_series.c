@@ -0,0 +1,129 @@
+#include <math.h>
+#include "pi_series.h"
+
+// Terms past these are below the smallest double and add exactly nothing:
+// k! / (2k + 1)!! ~ 2^-k, 5^-(2k + 1) and 16^-k
+#define EULER_TERMS 1100
+#define MACHIN_TERMS 232
+#define BBP_TERMS 269
+
+const char* series_name(series_method method) {
+    switch (method) {
+        case SERIES_EULER:  return "Euler Transformed Liebniz";
+        case SERIES_MACHIN: return "Machin Formula";
+        default:            return "Bailey-Borwein-Plouffe";
+    }
+}
+
+// terms of the first size that can still change the sum
+uint64_t series_terms(series_method method, uint64_t size) {
+    uint64_t limit;
+    switch (method) {
+        case SERIES_EULER:  limit = EULER_TERMS; break;
+        case SERIES_MACHIN: limit = MACHIN_TERMS; break;
+        default:            limit = BBP_TERMS; break;
+    }
+    return size < limit ? size : limit;
+}
+
+// sum k! / (2k + 1)!! over [first, first + count), times 2; the first term
+// comes from the product of the ones before, the rest from the ratio
+// k / (2k + 1) of neighbours
+static double euler_range(uint64_t first, uint64_t count) {
+    double t = 1.0;
+    for(uint64_t k = 1; k <= first; k++) {
+        t *= (double) k / (double) (2 * k + 1);
+    }
+    double sum = 0.0;
+    for(uint64_t k = first; k < first + count; k++) {
+        sum += t;
+        t *= (double) (k + 1) / (double) (2 * k + 3);
+    }
+    return 2.0 * sum;
+}
+
+// terms [first, first + count) of the arctan(1/x) series
+static double arctan_inv_range(double x, uint64_t first, uint64_t count) {
+    double power = pow(x, -(double) (2 * first + 1));
+    double inv_x2 = 1.0 / (x * x);
+    double sum = 0.0;
+    for(uint64_t k = first; k < first + count; k++) {
+        double sign = 1.0 - 2.0 * (double) (k & 1);
+        sum += sign * power / (double) (2 * k + 1);
+        power *= inv_x2;
+    }
+    return sum;
+}
+
+static double machin_range(uint64_t first, uint64_t count) {
+    return 16.0 * arctan_inv_range(5.0, first, count) - 4.0 * arctan_inv_range(239.0, first, count);
+}
+
+static double bbp_range(uint64_t first, uint64_t count) {
+    double power = pow(16.0, -(double) first);
+    double sum = 0.0;
+    for(uint64_t k = first; k < first + count; k++) {
+        double k8 = 8.0 * (double) k;
+        sum += power * (4.0 / (k8 + 1.0) - 2.0 / (k8 + 4.0) - 1.0 / (k8 + 5.0) - 1.0 / (k8 + 6.0));
+        power *= 1.0 / 16.0;
+    }
+    return sum;
+}
+
+// contribution of the terms [first, first + count) to pi; every range can be
+// computed on its own, so the threads split the terms like the Liebniz ones
+double series_range(series_method method, uint64_t first, uint64_t count) {
+    switch (method) {
+        case SERIES_EULER:  return euler_range(first, count);
+        case SERIES_MACHIN: return machin_range(first, count);
+        default:            return bbp_range(first, count);
+    }
+}
+
+// 16^e mod m, in 64-bit products while m fits in 32 bits
+static uint64_t pow16_mod(uint64_t e, uint64_t m) {
+    if (m == 1) return 0;
+    if (m <= UINT32_MAX) {
+        uint64_t result = 1, base = 16 % m;
+        while (e > 0) {
+            if (e & 1) result = result * base % m;
+            base = base * base % m;
+            e >>= 1;
+        }
+        return result;
+    }
+    unsigned __int128 result = 1, base = 16 % m;
+    while (e > 0) {
+        if (e & 1) result = result * base % m;
+        base = base * base % m;
+        e >>= 1;
+    }
+    return (uint64_t) result;
+}
+
+// fractional part of sum 16^(d - k) / (8k + j) over all k
+static double bbp_series(int j, uint64_t d) {
+    double s = 0.0;
+    for(uint64_t k = 0; k <= d; k++) {
+        uint64_t m = 8 * k + j;
+        s += (double) pow16_mod(d - k, m) / (double) m;
+        s -= floor(s);
+    }
+    // the tail is below 16^-15 after 15 terms
+    double power = 1.0 / 16.0;
+    for(uint64_t k = d + 1; k <= d + 15; k++) {
+        s += power / (double) (8 * k + j);
+        power *= 1.0 / 16.0;
+    }
+    return s - floor(s);
+}
+
+// Hex digit of pi at position (1 is the first after the point) by BBP digit
+// extraction. No digit before it is needed, so every thread can take its own
+// positions.
+int bbp_hex_digit(uint64_t position) {
+    uint64_t d = position - 1;
+    double x = 4.0 * bbp_series(1, d) - 2.0 * bbp_series(4, d) - bbp_series(5, d) - bbp_series(6, d);
+    x -= floor(x);
+    return (int) (16.0 * x);
+}
@@ -0,0 +1,22 @@
+#ifndef PI_SERIES_H
+#define PI_SERIES_H
+
+#include <stdint.h>
+
+// Faster converging series behind -p; the numbers follow the existing
+// 0 (Monte-Carlo) and 1 (Liebniz)
+typedef enum {
+    SERIES_EULER = 2,   // Euler transformed Liebniz, pi = 2 * sum k! / (2k + 1)!!
+    SERIES_MACHIN = 3,  // pi = 16 arctan(1/5) - 4 arctan(1/239)
+    SERIES_BBP = 4      // Bailey-Borwein-Plouffe, 1/16^k per term
+} series_method;
+
+// pi to double precision, the reference the methods are measured against
+#define PI_REFERENCE 3.14159265358979323846
+
+const char* series_name(series_method method);
+uint64_t series_terms(series_method method, uint64_t size);
+double series_range(series_method method, uint64_t first, uint64_t count);
+int bbp_hex_digit(uint64_t position);
+
+#endif /*PI_SERIES_H*/
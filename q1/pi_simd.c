@@ -0,0 +1,230 @@
+#include <string.h>
+#include "pi_simd.h"
+#include "pi_rng.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define HAVE_X86 1
+#endif
+
+// keys of the 10 Philox rounds, the same for every counter
+static void key_schedule(uint64_t seed, uint32_t k0[10], uint32_t k1[10]) {
+    k0[0] = (uint32_t) seed;
+    k1[0] = (uint32_t) (seed >> 32);
+    for(int r = 1; r < 10; r++) {
+        k0[r] = k0[r - 1] + PHILOX_W0;
+        k1[r] = k1[r - 1] + PHILOX_W1;
+    }
+}
+
+static long count_philox_scalar(uint64_t seed, uint64_t first, long n) {
+    long hits = 0;
+    uint32_t w[4];
+    for(long i = 0; i < n; i++) {
+        philox4x32(first + i, seed, w);
+        double x = rng_to_double(((uint64_t) w[1] << 32) | w[0]);
+        double y = rng_to_double(((uint64_t) w[3] << 32) | w[2]);
+        hits += (x * x + y * y <= 1.0);
+    }
+    return hits;
+}
+
+static long count_points_scalar(const double* points, int n) {
+    long hits = 0;
+    for(int i = 0; i < n; i++) {
+        double x = points[2 * i];
+        double y = points[2 * i + 1];
+        hits += (x * x + y * y <= 1.0);
+    }
+    return hits;
+}
+
+#ifdef HAVE_X86
+
+// The vector kernels keep one Philox counter per 64-bit lane, so the 32x32 bit
+// products come from a single unsigned multiply of the low halves. The 53 bit
+// integers are turned into doubles exactly through their 2^52-biased 32 bit
+// halves, which gives the same points as the scalar path.
+
+__attribute__((target("avx2")))
+static __m256d u53_to_unit_avx2(__m256i v) {
+    const __m256i lo32 = _mm256_set1_epi64x(0xFFFFFFFFLL);
+    const __m256i bias = _mm256_set1_epi64x(0x4330000000000000LL);
+    const __m256d two52 = _mm256_set1_pd(4503599627370496.0);
+    __m256d hi = _mm256_sub_pd(_mm256_castsi256_pd(_mm256_or_si256(_mm256_srli_epi64(v, 32), bias)), two52);
+    __m256d lo = _mm256_sub_pd(_mm256_castsi256_pd(_mm256_or_si256(_mm256_and_si256(v, lo32), bias)), two52);
+    __m256d d = _mm256_add_pd(_mm256_mul_pd(hi, _mm256_set1_pd(4294967296.0)), lo);
+    return _mm256_mul_pd(d, _mm256_set1_pd(1.0 / 9007199254740992.0));
+}
+
+// 4 points per iteration
+__attribute__((target("avx2")))
+static long count_philox_avx2(uint64_t seed, uint64_t first, long n) {
+    uint32_t k0[10], k1[10];
+    key_schedule(seed, k0, k1);
+    const __m256i lo32 = _mm256_set1_epi64x(0xFFFFFFFFLL);
+    const __m256i m0 = _mm256_set1_epi64x(PHILOX_M0);
+    const __m256i m1 = _mm256_set1_epi64x(PHILOX_M1);
+    const __m256d one = _mm256_set1_pd(1.0);
+    __m256i ctr = _mm256_add_epi64(_mm256_set1_epi64x((long long) first), _mm256_set_epi64x(3, 2, 1, 0));
+
+    long hits = 0;
+    long i = 0;
+    for(; i + 4 <= n; i += 4) {
+        __m256i c0 = _mm256_and_si256(ctr, lo32);
+        __m256i c1 = _mm256_srli_epi64(ctr, 32);
+        __m256i c2 = _mm256_setzero_si256();
+        __m256i c3 = _mm256_setzero_si256();
+        for(int r = 0; r < 10; r++) {
+            __m256i p0 = _mm256_mul_epu32(c0, m0);
+            __m256i p1 = _mm256_mul_epu32(c2, m1);
+            c0 = _mm256_xor_si256(_mm256_xor_si256(_mm256_srli_epi64(p1, 32), c1), _mm256_set1_epi64x(k0[r]));
+            c2 = _mm256_xor_si256(_mm256_xor_si256(_mm256_srli_epi64(p0, 32), c3), _mm256_set1_epi64x(k1[r]));
+            c1 = _mm256_and_si256(p1, lo32);
+            c3 = _mm256_and_si256(p0, lo32);
+        }
+        __m256d x = u53_to_unit_avx2(_mm256_srli_epi64(_mm256_or_si256(_mm256_slli_epi64(c1, 32), c0), 11));
+        __m256d y = u53_to_unit_avx2(_mm256_srli_epi64(_mm256_or_si256(_mm256_slli_epi64(c3, 32), c2), 11));
+        __m256d d = _mm256_add_pd(_mm256_mul_pd(x, x), _mm256_mul_pd(y, y));
+        hits += __builtin_popcount(_mm256_movemask_pd(_mm256_cmp_pd(d, one, _CMP_LE_OQ)));
+        ctr = _mm256_add_epi64(ctr, _mm256_set1_epi64x(4));
+    }
+    return hits + count_philox_scalar(seed, first + i, n - i);
+}
+
+// 2 interleaved points per vector, x * x + y * y ends up in the even lanes
+__attribute__((target("avx2")))
+static long count_points_avx2(const double* points, int n) {
+    const __m256d one = _mm256_set1_pd(1.0);
+    long hits = 0;
+    int i = 0;
+    for(; i + 2 <= n; i += 2) {
+        __m256d v = _mm256_loadu_pd(points + 2 * i);
+        __m256d sq = _mm256_mul_pd(v, v);
+        __m256d d = _mm256_add_pd(sq, _mm256_permute_pd(sq, 0x5));
+        hits += __builtin_popcount(_mm256_movemask_pd(_mm256_cmp_pd(d, one, _CMP_LE_OQ)) & 0x5);
+    }
+    return hits + count_points_scalar(points + 2 * i, n - i);
+}
+
+__attribute__((target("avx512f")))
+static __m512d u53_to_unit_avx512(__m512i v) {
+    const __m512i lo32 = _mm512_set1_epi64(0xFFFFFFFFLL);
+    const __m512i bias = _mm512_set1_epi64(0x4330000000000000LL);
+    const __m512d two52 = _mm512_set1_pd(4503599627370496.0);
+    __m512d hi = _mm512_sub_pd(_mm512_castsi512_pd(_mm512_or_si512(_mm512_srli_epi64(v, 32), bias)), two52);
+    __m512d lo = _mm512_sub_pd(_mm512_castsi512_pd(_mm512_or_si512(_mm512_and_si512(v, lo32), bias)), two52);
+    __m512d d = _mm512_add_pd(_mm512_mul_pd(hi, _mm512_set1_pd(4294967296.0)), lo);
+    return _mm512_mul_pd(d, _mm512_set1_pd(1.0 / 9007199254740992.0));
+}
+
+// 8 points per iteration
+__attribute__((target("avx512f")))
+static long count_philox_avx512(uint64_t seed, uint64_t first, long n) {
+    uint32_t k0[10], k1[10];
+    key_schedule(seed, k0, k1);
+    const __m512i lo32 = _mm512_set1_epi64(0xFFFFFFFFLL);
+    const __m512i m0 = _mm512_set1_epi64(PHILOX_M0);
+    const __m512i m1 = _mm512_set1_epi64(PHILOX_M1);
+    const __m512d one = _mm512_set1_pd(1.0);
+    __m512i ctr = _mm512_add_epi64(_mm512_set1_epi64((long long) first), _mm512_set_epi64(7, 6, 5, 4, 3, 2, 1, 0));
+
+    long hits = 0;
+    long i = 0;
+    for(; i + 8 <= n; i += 8) {
+        __m512i c0 = _mm512_and_si512(ctr, lo32);
+        __m512i c1 = _mm512_srli_epi64(ctr, 32);
+        __m512i c2 = _mm512_setzero_si512();
+        __m512i c3 = _mm512_setzero_si512();
+        for(int r = 0; r < 10; r++) {
+            __m512i p0 = _mm512_mul_epu32(c0, m0);
+            __m512i p1 = _mm512_mul_epu32(c2, m1);
+            c0 = _mm512_xor_si512(_mm512_xor_si512(_mm512_srli_epi64(p1, 32), c1), _mm512_set1_epi64(k0[r]));
+            c2 = _mm512_xor_si512(_mm512_xor_si512(_mm512_srli_epi64(p0, 32), c3), _mm512_set1_epi64(k1[r]));
+            c1 = _mm512_and_si512(p1, lo32);
+            c3 = _mm512_and_si512(p0, lo32);
+        }
+        __m512d x = u53_to_unit_avx512(_mm512_srli_epi64(_mm512_or_si512(_mm512_slli_epi64(c1, 32), c0), 11));
+        __m512d y = u53_to_unit_avx512(_mm512_srli_epi64(_mm512_or_si512(_mm512_slli_epi64(c3, 32), c2), 11));
+        __m512d d = _mm512_add_pd(_mm512_mul_pd(x, x), _mm512_mul_pd(y, y));
+        hits += __builtin_popcount(_mm512_cmp_pd_mask(d, one, _CMP_LE_OQ));
+        ctr = _mm512_add_epi64(ctr, _mm512_set1_epi64(8));
+    }
+    return hits + count_philox_scalar(seed, first + i, n - i);
+}
+
+// 4 interleaved points per vector
+__attribute__((target("avx512f")))
+static long count_points_avx512(const double* points, int n) {
+    const __m512d one = _mm512_set1_pd(1.0);
+    long hits = 0;
+    int i = 0;
+    for(; i + 4 <= n; i += 4) {
+        __m512d v = _mm512_loadu_pd(points + 2 * i);
+        __m512d sq = _mm512_mul_pd(v, v);
+        __m512d d = _mm512_add_pd(sq, _mm512_permute_pd(sq, 0x55));
+        hits += __builtin_popcount(_mm512_cmp_pd_mask(d, one, _CMP_LE_OQ) & 0x55);
+    }
+    return hits + count_points_scalar(points + 2 * i, n - i);
+}
+
+#endif
+
+PiKernels pi_simd = { SIMD_SCALAR, count_philox_scalar, count_points_scalar };
+
+// parse "scalar", "avx2", "avx512" or "auto" (best supported), 0 on success
+int parse_simd(const char* s, simd_level* out) {
+    if (strcmp(s, "scalar") == 0) {
+        *out = SIMD_SCALAR;
+    } else if (strcmp(s, "avx2") == 0) {
+        *out = SIMD_AVX2;
+    } else if (strcmp(s, "avx512") == 0) {
+        *out = SIMD_AVX512;
+    } else if (strcmp(s, "auto") == 0) {
+        *out = simd_detect();
+    } else {
+        return -1;
+    }
+    return 0;
+}
+
+const char* simd_name(simd_level level) {
+    switch (level) {
+        case SIMD_AVX2:   return "avx2";
+        case SIMD_AVX512: return "avx512";
+        default:          return "scalar";
+    }
+}
+
+// best instruction set the cpu supports
+simd_level simd_detect() {
+#ifdef HAVE_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) return SIMD_AVX512;
+    if (__builtin_cpu_supports("avx2")) return SIMD_AVX2;
+#endif
+    return SIMD_SCALAR;
+}
+
+// switch the kernels to the given level, or the best one below it the cpu
+// supports; returns the level in use
+simd_level simd_select(simd_level level) {
+    simd_level best = simd_detect();
+    if (level > best) level = best;
+
+    pi_simd.level = SIMD_SCALAR;
+    pi_simd.count_philox = count_philox_scalar;
+    pi_simd.count_points = count_points_scalar;
+#ifdef HAVE_X86
+    if (level == SIMD_AVX2) {
+        pi_simd.level = SIMD_AVX2;
+        pi_simd.count_philox = count_philox_avx2;
+        pi_simd.count_points = count_points_avx2;
+    } else if (level == SIMD_AVX512) {
+        pi_simd.level = SIMD_AVX512;
+        pi_simd.count_philox = count_philox_avx512;
+        pi_simd.count_points = count_points_avx512;
+    }
+#endif
+    return pi_simd.level;
+}
@@ -0,0 +1,29 @@
+#ifndef PI_SIMD_H
+#define PI_SIMD_H
+
+#include <stdint.h>
+
+typedef enum {
+    SIMD_SCALAR,
+    SIMD_AVX2,
+    SIMD_AVX512
+} simd_level;
+
+// Monte-Carlo kernels, scalar until simd_select picks a vector instruction
+// set. Every level counts exactly the same points as the scalar one.
+typedef struct {
+    simd_level level;
+    // points in the circle among Philox points [first, first + n) for seed
+    long (*count_philox)(uint64_t seed, uint64_t first, long n);
+    // points in the circle among n interleaved (x, y) pairs
+    long (*count_points)(const double* points, int n);
+} PiKernels;
+
+extern PiKernels pi_simd;
+
+int parse_simd(const char* s, simd_level* out);
+const char* simd_name(simd_level level);
+simd_level simd_detect();
+simd_level simd_select(simd_level level);
+
+#endif /*PI_SIMD_H*/
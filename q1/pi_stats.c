@@ -0,0 +1,36 @@
+#include <math.h>
+#include "pi_stats.h"
+
+// z with P(|Z| <= z) = level for a standard normal Z, by bisection on erfc
+double normal_quantile(double level) {
+    double lo = 0.0, hi = 40.0;
+    for(int i = 0; i < 200; i++) {
+        double mid = 0.5 * (lo + hi);
+        if (erfc(mid / sqrt(2.0)) > 1.0 - level) {
+            lo = mid;
+        } else {
+            hi = mid;
+        }
+    }
+    return 0.5 * (lo + hi);
+}
+
+// standard error of 4 h / n: every point is a Bernoulli trial with p = h / n
+double mc_std_error(uint64_t hits, uint64_t n) {
+    if (n == 0) return INFINITY;
+    double p = (double) hits / (double) n;
+    return 4.0 * sqrt(p * (1.0 - p) / (double) n);
+}
+
+// Samples of the next round after hits of n: the estimate of the samples still
+// needed for z * error <= tol, at least MC_ROUND, at most n (so a poor early
+// estimate costs at most twice the samples) and at most max.
+uint64_t mc_next_round(uint64_t hits, uint64_t n, double z, double tol, uint64_t max) {
+    if (n == 0) return MC_ROUND < max ? MC_ROUND : max;
+    double p = (double) hits / (double) n;
+    double need = 16.0 * z * z * p * (1.0 - p) / (tol * tol);
+    uint64_t round = need > (double) n ? (uint64_t) (need - (double) n) + 1 : 0;
+    if (round > n) round = n;
+    if (round < MC_ROUND) round = MC_ROUND;
+    return round < max ? round : max;
+}
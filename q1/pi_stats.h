@@ -0,0 +1,14 @@
+#ifndef PI_STATS_H
+#define PI_STATS_H
+
+#include <stdint.h>
+
+// samples of the first round of an adaptive Monte-Carlo run, and the least
+// any later round adds
+#define MC_ROUND (1ULL << 20)
+
+double normal_quantile(double level);
+double mc_std_error(uint64_t hits, uint64_t n);
+uint64_t mc_next_round(uint64_t hits, uint64_t n, double z, double tol, uint64_t max);
+
+#endif /*PI_STATS_H*/
@@ -0,0 +1,130 @@
+#include <math.h>
+#include <string.h>
+#include "pi_sum.h"
+
+// parse "naive", "kahan", "pairwise" or "paired", 0 on success
+int parse_sum(const char* s, sum_mode* out) {
+    if (strcmp(s, "naive") == 0) {
+        *out = SUM_NAIVE;
+    } else if (strcmp(s, "kahan") == 0) {
+        *out = SUM_KAHAN;
+    } else if (strcmp(s, "pairwise") == 0) {
+        *out = SUM_PAIRWISE;
+    } else if (strcmp(s, "paired") == 0) {
+        *out = SUM_PAIRED;
+    } else {
+        return -1;
+    }
+    return 0;
+}
+
+const char* sum_name(sum_mode mode) {
+    switch (mode) {
+        case SUM_KAHAN:    return "kahan";
+        case SUM_PAIRWISE: return "pairwise";
+        case SUM_PAIRED:   return "paired";
+        default:           return "naive";
+    }
+}
+
+// term i of 1 - 1/3 + 1/5 - ..., the sign without a branch
+double liebniz_term(uint64_t i) {
+    double sign = 1.0 - 2.0 * (double) (i & 1);
+    return sign / (double) (2 * i + 1);
+}
+
+static double naive_range(uint64_t first, uint64_t count) {
+    double sum = 0.0;
+    for(uint64_t i = first; i < first + count; i++) {
+        sum += liebniz_term(i);
+    }
+    return sum;
+}
+
+// Neumaier's variant of Kahan summation, also exact when a term is larger
+// than the running sum
+static double kahan_range(uint64_t first, uint64_t count) {
+    double sum = 0.0, c = 0.0;
+    for(uint64_t i = first; i < first + count; i++) {
+        double x = liebniz_term(i);
+        double t = sum + x;
+        if (fabs(sum) >= fabs(x)) {
+            c += (sum - t) + x;
+        } else {
+            c += (x - t) + sum;
+        }
+        sum = t;
+    }
+    return sum + c;
+}
+
+// rounding error grows with log(count) instead of count
+static double pairwise_range(uint64_t first, uint64_t count) {
+    if (count <= SUM_LEAF) {
+        return naive_range(first, count);
+    }
+    uint64_t half = count / 2;
+    return pairwise_range(first, half) + pairwise_range(first + half, count - half);
+}
+
+// Consecutive terms of opposite sign combined into one positive term, so
+// nothing cancels and there is no sign to pick. The pairs are added from the
+// smallest up, otherwise the tail falls below the rounding of the sum.
+static double paired_range(uint64_t first, uint64_t count) {
+    double sum = 0.0;
+    double head = 0.0;
+    if (count > 0 && (first & 1)) {
+        head = liebniz_term(first);
+        first++;
+        count--;
+    }
+    if (count & 1) {
+        sum += liebniz_term(first + count - 1);
+    }
+    for(uint64_t k = (first + count) / 2; k > first / 2; k--) {
+        double d = 4.0 * (double) (k - 1);
+        sum += 2.0 / ((d + 1.0) * (d + 3.0));
+    }
+    return sum + head;
+}
+
+// sum of the terms [first, first + count)
+double liebniz_range(sum_mode mode, uint64_t first, uint64_t count) {
+    switch (mode) {
+        case SUM_KAHAN:    return kahan_range(first, count);
+        case SUM_PAIRWISE: return pairwise_range(first, count);
+        case SUM_PAIRED:   return paired_range(first, count);
+        default:           return naive_range(first, count);
+    }
+}
+
+// add a partial sum, keeping the rounding error aside in SUM_KAHAN mode
+void acc_add(sum_mode mode, sum_acc* acc, double x) {
+    if (mode != SUM_KAHAN) {
+        acc->sum += x;
+        return;
+    }
+    double t = acc->sum + x;
+    if (fabs(acc->sum) >= fabs(x)) {
+        acc->c += (acc->sum - t) + x;
+    } else {
+        acc->c += (x - t) + acc->sum;
+    }
+    acc->sum = t;
+}
+
+double acc_value(const sum_acc* acc) {
+    return acc->sum + acc->c;
+}
+
+// add v[0..n) in pairs of growing distance, always in the same order;
+// overwrites v and returns the total
+double sum_tree(double* v, uint64_t n) {
+    if (n == 0) return 0.0;
+    for(uint64_t step = 1; step < n; step *= 2) {
+        for(uint64_t i = 0; i + step < n; i += 2 * step) {
+            v[i] += v[i + step];
+        }
+    }
+    return v[0];
+}
@@ -0,0 +1,35 @@
+#ifndef PI_SUM_H
+#define PI_SUM_H
+
+#include <stdint.h>
+
+// How the Liebniz terms of a range are added up
+typedef enum {
+    SUM_NAIVE,      // one running double, in term order
+    SUM_KAHAN,      // Neumaier compensated running sum
+    SUM_PAIRWISE,   // recursive halving down to SUM_LEAF terms
+    SUM_PAIRED      // terms 2k and 2k + 1 as one 2 / ((4k + 1)(4k + 3))
+} sum_mode;
+
+// terms added in order at the bottom of the pairwise recursion
+#define SUM_LEAF 128
+
+// terms per block of the deterministic reduction, fixed so the blocks (and the
+// result) are the same for any number of threads and in both programs
+#define SUM_BLOCK (1 << 16)
+
+// running total of partial sums, compensated in SUM_KAHAN mode
+typedef struct {
+    double sum;
+    double c;
+} sum_acc;
+
+int parse_sum(const char* s, sum_mode* out);
+const char* sum_name(sum_mode mode);
+double liebniz_term(uint64_t i);
+double liebniz_range(sum_mode mode, uint64_t first, uint64_t count);
+void acc_add(sum_mode mode, sum_acc* acc, double x);
+double acc_value(const sum_acc* acc);
+double sum_tree(double* v, uint64_t n);
+
+#endif /*PI_SUM_H*/
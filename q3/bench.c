@@ -0,0 +1,166 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <omp.h>
+#include "bench.h"
+#include "graph_io.h"
+#include "graph_gen.h"
+
+static const char* alg_names[] = { "spec", "jp", "seq" };
+
+const char* alg_name(color_alg alg) {
+    return alg_names[alg];
+}
+
+// parse "1,2,4,8" into out, returns the count or -1 on a bad entry
+int parse_int_list(const char* s, int* out, int max) {
+    int n = 0;
+    while (*s && n < max) {
+        char* end;
+        long v = strtol(s, &end, 10);
+        if (end == s || v <= 0) return -1;
+        out[n++] = (int) v;
+        s = (*end == ',') ? end + 1 : end;
+    }
+    return n;
+}
+
+// parse "spec,jp,seq" into out, returns the count or -1 on an unknown name
+int parse_alg_list(const char* s, color_alg* out, int max) {
+    int n = 0;
+    while (*s && n < max) {
+        size_t len = strcspn(s, ",");
+        int found = 0;
+        for(int a = 0; a <= ALG_SEQUENTIAL; a++) {
+            if (strlen(alg_names[a]) == len && strncmp(s, alg_names[a], len) == 0) {
+                out[n++] = (color_alg) a;
+                found = 1;
+            }
+        }
+        if (!found) return -1;
+        s += len;
+        if (*s == ',') s++;
+    }
+    return n;
+}
+
+static int cmp_double(const void* a, const void* b) {
+    double x = *(const double*) a;
+    double y = *(const double*) b;
+    return (x > y) - (x < y);
+}
+
+// nearest-rank percentile of sorted values
+static double percentile(const double* sorted, int n, double pct) {
+    int rank = (int) (pct / 100.0 * n + 0.999999);
+    if (rank < 1) rank = 1;
+    if (rank > n) rank = n;
+    return sorted[rank - 1];
+}
+
+// graph arguments are files if they exist, generator specs otherwise
+static int load_input(Graph* g, const char* name, unsigned long seed) {
+    if (access(name, R_OK) == 0) {
+        return loadGraph(g, name);
+    }
+    return generateGraph(g, name, seed);
+}
+
+// graph names are generator specs with commas, so they are always quoted
+static void print_quoted(FILE* out, const char* s, int json) {
+    fputc('"', out);
+    for(; *s; s++) {
+        if (*s == '"' || (json && *s == '\\')) fputc(json ? '\\' : '"', out);
+        fputc(*s, out);
+    }
+    fputc('"', out);
+}
+
+// Run every algorithm at every thread count on every graph, with warmups and
+// repetitions, and write one CSV row / JSON object per configuration. The
+// speedup is against the first thread count of the sweep (list 1 first to
+// get speedup vs 1 thread). Returns 0, or -1 if a graph could not be loaded.
+int runBenchmark(BenchConfig* cfg, char** graphs, int nGraphs, FILE* out) {
+    int maxThreads = omp_get_max_threads();
+    double* times = (double*) malloc(sizeof(double) * (cfg->reps > 0 ? cfg->reps : 1));
+    int first = 1;
+
+    if (cfg->json) {
+        fprintf(out, "[\n");
+    } else {
+        fprintf(out, "graph,vertices,edges,algorithm,order,threads,reps,median_ms,p95_ms,min_ms,rounds,colors,valid,speedup\n");
+    }
+
+    for(int gi = 0; gi < nGraphs; gi++) {
+        Graph graph;
+        omp_set_num_threads(maxThreads);
+        if (load_input(&graph, graphs[gi], cfg->seed) != 0) {
+            free(times);
+            return -1;
+        }
+        uint32_t* rank = NULL;
+        int* order = (cfg->ord != ORDER_NATURAL) ? orderVertices(&graph, cfg->ord, cfg->seed, &rank) : NULL;
+
+        for(int ai = 0; ai < cfg->nAlgs; ai++) {
+            color_alg alg = cfg->algs[ai];
+            double baseline = 0.0;
+
+            for(int ti = 0; ti < cfg->nThreads; ti++) {
+                int rounds = 1, maxRounds = 0, colors = 0, valid = 1;
+                omp_set_num_threads(cfg->threads[ti]);
+
+                for(int w = 0; w < cfg->warmups; w++) {
+                    free(colorGraph(&graph, alg, '1', graph.nVertices, order, rank, cfg->seed, &rounds));
+                }
+                for(int r = 0; r < cfg->reps; r++) {
+                    double t1 = CLOCK();
+                    int* result = colorGraph(&graph, alg, '1', graph.nVertices, order, rank, cfg->seed, &rounds);
+                    times[r] = CLOCK() - t1;
+
+                    if (rounds > maxRounds) maxRounds = rounds;
+                    colors = count_colors(result, graph.nVertices);
+                    if (conflicts_exist(result, &graph)) valid = 0;
+                    free(result);
+                }
+
+                qsort(times, cfg->reps, sizeof(double), cmp_double);
+                double median = (cfg->reps % 2) ? times[cfg->reps / 2]
+                                                : 0.5 * (times[cfg->reps / 2 - 1] + times[cfg->reps / 2]);
+                double p95 = percentile(times, cfg->reps, 95.0);
+                if (ti == 0) baseline = median;
+                double speedup = (median > 0.0) ? baseline / median : 0.0;
+
+                if (cfg->json) {
+                    fprintf(out, "%s  {\"graph\": ", first ? "" : ",\n");
+                    print_quoted(out, graphs[gi], 1);
+                    fprintf(out, ", \"vertices\": %d, \"edges\": %ld, \"algorithm\": \"%s\", \"order\": \"%s\", "
+                                 "\"threads\": %d, \"reps\": %d, \"median_ms\": %.6f, \"p95_ms\": %.6f, \"min_ms\": %.6f, "
+                                 "\"rounds\": %d, \"colors\": %d, \"valid\": %s, \"speedup\": %.4f}",
+                            graph.nVertices, (long) graph.nEdges, alg_name(alg), order_name(cfg->ord),
+                            cfg->threads[ti], cfg->reps, median, p95, times[0],
+                            maxRounds, colors, valid ? "true" : "false", speedup);
+                } else {
+                    print_quoted(out, graphs[gi], 0);
+                    fprintf(out, ",%d,%ld,%s,%s,%d,%d,%.6f,%.6f,%.6f,%d,%d,%d,%.4f\n",
+                            graph.nVertices, (long) graph.nEdges, alg_name(alg), order_name(cfg->ord),
+                            cfg->threads[ti], cfg->reps, median, p95, times[0],
+                            maxRounds, colors, valid, speedup);
+                }
+                first = 0;
+                fflush(out);
+            }
+        }
+
+        free(order);
+        free(rank);
+        deleteGraph(&graph);
+    }
+
+    if (cfg->json) {
+        fprintf(out, "\n]\n");
+    }
+    omp_set_num_threads(maxThreads);
+    free(times);
+    return 0;
+}
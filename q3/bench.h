@@ -0,0 +1,27 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <stdio.h>
+#include "color_graph.h"
+#include "graph_order.h"
+
+#define BENCH_MAX_LIST 32
+
+typedef struct {
+    int threads[BENCH_MAX_LIST];        // thread counts to sweep
+    int nThreads;
+    color_alg algs[BENCH_MAX_LIST];     // algorithms to sweep
+    int nAlgs;
+    int warmups;                        // untimed runs before each measurement
+    int reps;                           // timed runs per configuration
+    int json;                           // 1 -> JSON report, 0 -> CSV
+    vertex_order ord;                   // order passed to every run
+    unsigned long seed;                 // seed for generators, random order and JP
+} BenchConfig;
+
+int parse_int_list(const char* s, int* out, int max);
+int parse_alg_list(const char* s, color_alg* out, int max);
+const char* alg_name(color_alg alg);
+int runBenchmark(BenchConfig* cfg, char** graphs, int nGraphs, FILE* out);
+
+#endif /*BENCH_H*/
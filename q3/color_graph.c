@@ -5,6 +5,13 @@
 #include <unistd.h>
 #include <string.h>
 #include "color_graph.h"
+#include "graph_io.h"
+#include "graph_order.h"
+#include "graph_gen.h"
+#include "bench.h"
+#include "color_stats.h"
+#include "color_simd.h"
+#include "graph_dense.h"
 
 // initialize clock
 double CLOCK() {
@@ -13,219 +20,1538 @@ double CLOCK() {
     return (t.tv_sec * 1000) + (t.tv_nsec*1e-6);
 }
 
+// in-place inclusive prefix sum over a[0..n), split into one block per thread
+static void prefix_sum(eid_t* a, int n) {
+    int nBlocks = omp_get_max_threads();
+    eid_t block_sum[nBlocks + 1];
+    block_sum[0] = 0;
+
+    #pragma omp parallel num_threads(nBlocks)
+    {
+        int t = omp_get_thread_num();
+        int nt = omp_get_num_threads();
+        int lo = (int) (((long) n * t) / nt);
+        int hi = (int) (((long) n * (t + 1)) / nt);
+
+        // scan own block
+        for(int i = lo + 1; i < hi; i++) {
+            a[i] += a[i - 1];
+        }
+        block_sum[t + 1] = (hi > lo) ? a[hi - 1] : 0;
+
+        #pragma omp barrier
+        #pragma omp single
+        for(int b = 1; b <= nt; b++) {
+            block_sum[b] += block_sum[b - 1];
+        }
+
+        // shift block by everything before it
+        for(int i = lo; i < hi; i++) {
+            a[i] += block_sum[t];
+        }
+    }
+}
+
+// sort a CSR row in place; rows are mostly short so this avoids qsort's
+// comparator call per element
+void sort_ids(vid_t* a, eid_t len) {
+    while (len > 16) {
+        // median of three pivot, then Hoare partition
+        vid_t x = a[0], y = a[len / 2], z = a[len - 1];
+        vid_t pivot = (x < y) ? ((y < z) ? y : (x < z ? z : x)) : ((x < z) ? x : (y < z ? z : y));
+        eid_t i = -1, j = len;
+        for(;;) {
+            do { i++; } while (a[i] < pivot);
+            do { j--; } while (a[j] > pivot);
+            if (i >= j) break;
+            vid_t t = a[i]; a[i] = a[j]; a[j] = t;
+        }
+
+        // recurse into the smaller half, loop on the larger one
+        if (j + 1 < len - j - 1) {
+            sort_ids(a, j + 1);
+            a += j + 1;
+            len -= j + 1;
+        } else {
+            sort_ids(a + j + 1, len - j - 1);
+            len = j + 1;
+        }
+    }
+
+    for(eid_t i = 1; i < len; i++) {
+        vid_t key = a[i];
+        eid_t k = i - 1;
+        while (k >= 0 && a[k] > key) {
+            a[k + 1] = a[k];
+            k--;
+        }
+        a[k + 1] = key;
+    }
+}
+
 // initialize the graph with a given number of vertices
 void initGraph(Graph* graph, int vertices) {
     graph->nVertices = vertices;
-    graph->adjMatrix = (int**) malloc(sizeof(int*) * (vertices));
-    for(int i = 0; i < vertices; i++) {
-        // initialize each array
-        graph->adjMatrix[i] = (int *) malloc(sizeof(int) * vertices); 
-        memset(graph->adjMatrix[i], 0, sizeof(int) * vertices);
-    }
+    graph->nEdges = 0;
+    graph->maxDegree = 0;
+    graph->offsets = NULL;
+    graph->adj = NULL;
+    graph->matrix = NULL;
+    graph->rowWords = 0;
+
+    // start with an empty builder, edges are collected until finalizeGraph
+    graph->nPending = 0;
+    graph->capPending = 16;
+    graph->pending = (Edge*) malloc(sizeof(Edge) * graph->capPending);
 }
 
 // add an edge between vertices u and v
 void addEdge(Graph *graph, int u, int v) {
-    graph->adjMatrix[u][v] = 1;
-    graph->adjMatrix[v][u] = 1;
+    if (graph->nPending == graph->capPending) {
+        graph->capPending *= 2;
+        graph->pending = (Edge*) realloc(graph->pending, sizeof(Edge) * graph->capPending);
+    }
+    graph->pending[graph->nPending].u = u;
+    graph->pending[graph->nPending].v = v;
+    graph->nPending++;
     graph->nEdges++;
 }
 
-// frees up the memory allocated for the adjacent array
-void deleteGraph(Graph* graph) {
-    for(int i = 0; i < graph->nVertices; i++) {
-        free(graph->adjMatrix[i]);
+// turn the edges collected by addEdge into the CSR arrays
+void finalizeGraph(Graph* graph) {
+    Edge* edges = graph->pending;
+    eid_t nEdges = graph->nPending;
+
+    graph->pending = NULL;
+    graph->nPending = 0;
+    graph->capPending = 0;
+
+    free(graph->offsets);
+    free(graph->adj);
+    buildGraph(graph, graph->nVertices, edges, nEdges);
+    free(edges);
+}
+
+// build the CSR of an undirected graph from an edge list (self loops and
+// duplicate edges are dropped)
+void buildGraph(Graph* graph, int vertices, const Edge* edges, eid_t nEdges) {
+    int vert = vertices;
+    graph->nVertices = vert;
+
+    // count both endpoints of every edge, shifted by one for the prefix sum
+    eid_t* offsets = (eid_t*) calloc(vert + 1, sizeof(eid_t));
+    #pragma omp parallel for
+    for(eid_t e = 0; e < nEdges; e++) {
+        vid_t u = edges[e].u;
+        vid_t v = edges[e].v;
+        if (u == v) continue;
+        #pragma omp atomic
+        offsets[u + 1]++;
+        #pragma omp atomic
+        offsets[v + 1]++;
+    }
+    prefix_sum(offsets, vert + 1);
+
+    // scatter neighbors into their rows
+    eid_t* cursor = (eid_t*) malloc(sizeof(eid_t) * (vert + 1));
+    memcpy(cursor, offsets, sizeof(eid_t) * (vert + 1));
+    vid_t* adj = (vid_t*) malloc(sizeof(vid_t) * (offsets[vert] > 0 ? offsets[vert] : 1));
+
+    #pragma omp parallel for
+    for(eid_t e = 0; e < nEdges; e++) {
+        vid_t u = edges[e].u;
+        vid_t v = edges[e].v;
+        eid_t pu, pv;
+        if (u == v) continue;
+        #pragma omp atomic capture
+        pu = cursor[u]++;
+        #pragma omp atomic capture
+        pv = cursor[v]++;
+        adj[pu] = v;
+        adj[pv] = u;
     }
-    free(graph->adjMatrix);
+
+    // sort every row and drop duplicates, the new row length goes in cursor[u + 1]
+    cursor[0] = 0;
+    #pragma omp parallel for schedule(dynamic, 1024)
+    for(int u = 0; u < vert; u++) {
+        vid_t* row = adj + offsets[u];
+        eid_t len = offsets[u + 1] - offsets[u];
+        eid_t k = 0;
+
+        sort_ids(row, len);
+        for(eid_t i = 0; i < len; i++) {
+            if (k == 0 || row[i] != row[k - 1]) {
+                row[k++] = row[i];
+            }
+        }
+        cursor[u + 1] = k;
+    }
+    prefix_sum(cursor, vert + 1);
+
+    // compact rows into the final neighbor array
+    vid_t* packed = (vid_t*) malloc(sizeof(vid_t) * (cursor[vert] > 0 ? cursor[vert] : 1));
+    int maxDegree = 0;
+    #pragma omp parallel for schedule(dynamic, 1024) reduction(max:maxDegree)
+    for(int u = 0; u < vert; u++) {
+        eid_t len = cursor[u + 1] - cursor[u];
+        memcpy(packed + cursor[u], adj + offsets[u], sizeof(vid_t) * len);
+        if (len > maxDegree) maxDegree = (int) len;
+    }
+
+    free(adj);
+    free(offsets);
+
+    graph->offsets = cursor;
+    graph->adj = packed;
+    graph->nEdges = cursor[vert] / 2;
+    graph->maxDegree = maxDegree;
+    graph->matrix = NULL;
+    graph->rowWords = 0;
+    graph->pending = NULL;
+    graph->nPending = 0;
+    graph->capPending = 0;
 }
 
+// Build out as g with vertex order[i] renamed to i (order is a permutation)
+void permuteGraph(Graph* g, const int* order, Graph* out) {
+    int vert = g->nVertices;
+    int* newId = (int*) malloc(sizeof(int) * vert);
+    eid_t* offsets = (eid_t*) malloc(sizeof(eid_t) * (vert + 1));
+    vid_t* adj = (vid_t*) malloc(sizeof(vid_t) * (g->offsets[vert] > 0 ? g->offsets[vert] : 1));
+
+    offsets[0] = 0;
+    #pragma omp parallel for
+    for(int i = 0; i < vert; i++) {
+        newId[order[i]] = i;
+        offsets[i + 1] = DEGREE(g, order[i]);
+    }
+    prefix_sum(offsets, vert + 1);
+
+    // rename every row and sort it again
+    #pragma omp parallel for schedule(dynamic, 1024)
+    for(int i = 0; i < vert; i++) {
+        int u = order[i];
+        vid_t* row = adj + offsets[i];
+        eid_t len = offsets[i + 1] - offsets[i];
+        for(eid_t k = 0; k < len; k++) {
+            row[k] = newId[g->adj[g->offsets[u] + k]];
+        }
+        sort_ids(row, len);
+    }
+    free(newId);
+
+    out->nVertices = vert;
+    out->nEdges = g->nEdges;
+    out->maxDegree = g->maxDegree;
+    out->offsets = offsets;
+    out->adj = adj;
+    out->matrix = NULL;
+    out->rowWords = 0;
+    out->pending = NULL;
+    out->nPending = 0;
+    out->capPending = 0;
+}
+
+// frees up the memory allocated for the graph
+void deleteGraph(Graph* graph) {
+    free(graph->offsets);
+    free(graph->adj);
+    free(graph->matrix);
+    free(graph->pending);
+    graph->offsets = NULL;
+    graph->adj = NULL;
+    graph->matrix = NULL;
+    graph->pending = NULL;
+}
+
+// rows are sorted, so adjacency is a binary search in the row of u, or a
+// single bit test in a dense graph
 int isAdj(Graph* g, int u, int v) {
-    return (g->adjMatrix[u][v] == 1 && g->adjMatrix[v][u] == 1);
+    if (g->matrix) {
+        return (DENSE_ROW(g, u)[v >> 6] >> (v & 63)) & 1;
+    }
+    eid_t lo = g->offsets[u];
+    eid_t hi = g->offsets[u + 1];
+    while (lo < hi) {
+        eid_t mid = lo + (hi - lo) / 2;
+        if (g->adj[mid] == v) return 1;
+        if (g->adj[mid] < v) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return 0;
+}
+
+// per-thread queue of vertices that have to be recolored next round
+typedef struct {
+    int* items;
+    int n;
+    int cap;
+} worklist;
+
+static void worklist_push(worklist* w, int v) {
+    if (w->n == w->cap) {
+        w->cap = w->cap ? w->cap * 2 : 1024;
+        w->items = (int*) realloc(w->items, sizeof(int) * w->cap);
+    }
+    w->items[w->n++] = v;
+}
+
+// end of the neighbors of u with a lower id, rows are sorted
+static eid_t lower_end(Graph* g, int u) {
+    eid_t lo = g->offsets[u];
+    eid_t hi = g->offsets[u + 1];
+    while (lo < hi) {
+        eid_t mid = lo + (hi - lo) / 2;
+        if (g->adj[mid] < u) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+// 1 if a neighbor of u with a lower id has the color of u
+static int lower_conflict(Graph* g, int u, int* result) {
+    if (g->matrix) {
+        return dense_find_color(g, u, result, result[u], u);
+    }
+    eid_t start = g->offsets[u];
+    return color_simd.find_color(g->adj + start, lower_end(g, u) - start, result, result[u]);
 }
 
-// Function to check if conflicts exist in the coloring
+// vertices per chunk between checks of the shared conflict flag
+#define CONFLICT_CHUNK 1024
+
+// Function to check if conflicts exist in the coloring. The vertices are
+// handed out in chunks and every thread checks a shared flag before taking the
+// next one, so an invalid coloring stops the scan soon after the first conflict.
 int conflicts_exist(int *result, Graph* g) {
     int conflict = 0;
     int vert = g->nVertices;
-    int u; int v;
-    #pragma omp parallel for reduction(|:conflict)
-    for (u = 0; u < vert; u++) {
-        for (v = 0; v < vert; v++) {
-            if (isAdj(g, u, v) && result[u] == result[v]) {
-                conflict |= 1;
+    int nChunks = (vert + CONFLICT_CHUNK - 1) / CONFLICT_CHUNK;
+
+    // dense graphs AND each row with the bits of its own color class
+    uint64_t* classes = g->matrix ? dense_color_classes(g, result) : NULL;
+
+    #pragma omp parallel for schedule(dynamic, 1)
+    for (int c = 0; c < nChunks; c++) {
+        int stop;
+        #pragma omp atomic read
+        stop = conflict;
+        if (stop) continue;
+
+        int end = (c + 1) * CONFLICT_CHUNK < vert ? (c + 1) * CONFLICT_CHUNK : vert;
+        for (int u = c * CONFLICT_CHUNK; u < end && !stop; u++) {
+            if (classes) {
+                stop = dense_class_conflict(g, u, result, classes);
+            } else if (g->matrix) {
+                stop = dense_find_color(g, u, result, result[u], vert);
+            } else {
+                stop = color_simd.find_color(g->adj + g->offsets[u], DEGREE(g, u), result, result[u]);
             }
         }
+        if (stop) {
+            #pragma omp atomic write
+            conflict = 1;
+        }
     }
+    free(classes);
     return conflict;
 }
 
+// Collect the vertices that have to be recolored in one pass: uncolored ones
+// and the higher id endpoint of every conflicting edge. The list goes to out
+// (room for nVertices) in increasing id, returns its length.
+int collect_conflicts(int* result, Graph* g, int* out) {
+    int vert = g->nVertices;
+    int nThreads = omp_get_max_threads();
+    worklist queues[nThreads];
+    int starts[nThreads + 1];
+    memset(queues, 0, sizeof(queues));
+
+    #pragma omp parallel num_threads(nThreads)
+    {
+        int t = omp_get_thread_num();
+        worklist* q = &queues[t];
+
+        // static blocks keep the concatenated list sorted
+        #pragma omp for schedule(static)
+        for (int u = 0; u < vert; u++) {
+            if (result[u] < 0 || lower_conflict(g, u, result)) {
+                worklist_push(q, u);
+            }
+        }
+
+        #pragma omp single
+        {
+            starts[0] = 0;
+            for(int b = 0; b < nThreads; b++) {
+                starts[b + 1] = starts[b] + queues[b].n;
+            }
+        }
+        memcpy(out + starts[t], q->items, sizeof(int) * q->n);
+        free(q->items);
+    }
+    return starts[nThreads];
+}
+
+// per-thread bitset of colors taken by neighbors, grown to the largest degree
+// seen and reused across calls so get_color never allocates on its own stack
+static __thread uint64_t* forbidden = NULL;
+static __thread int forbiddenWords = 0;
+
+// release the calling thread's forbidden color bitset
+void free_color_scratch() {
+    free(forbidden);
+    forbidden = NULL;
+    forbiddenWords = 0;
+}
+
 // find smallest available color for given vertex
 int get_color(int v, int* result, Graph* g) {
-    int used_colors[g->nVertices];
-    memset(used_colors, 0, sizeof(used_colors));
+    // a vertex with d neighbors always has a free color in [0, d], so only
+    // d + 1 bits have to be cleared and scanned
+    // dense rows carry no degree, the largest one bounds the colors instead
+    int deg = g->matrix ? g->maxDegree : DEGREE(g, v);
+    int words = deg / 64 + 1;
+    if (words > forbiddenWords) {
+        free(forbidden);
+        forbidden = (uint64_t*) malloc(sizeof(uint64_t) * words);
+        forbiddenWords = words;
+    }
+    memset(forbidden, 0, sizeof(uint64_t) * words);
+
+    // Mark colors used by neighbors, then find the smallest available color,
+    // the first zero bit (-1 should not happen)
+    if (g->matrix) {
+        dense_mark_colors(g, v, result, deg, forbidden);
+    } else {
+        color_simd.mark_colors(g->adj + g->offsets[v], deg, result, deg, forbidden);
+    }
+    return color_simd.first_free(forbidden, words);
+}
+
+// per-thread bitset for distance-2 coloring, kept apart from the distance-1
+// one because its size is bounded by the 2-hop neighborhood
+static __thread uint64_t* forbidden2 = NULL;
+static __thread long forbidden2Words = 0;
+
+// release the calling thread's distance-2 bitset
+static void free_color_scratch_d2() {
+    free(forbidden2);
+    forbidden2 = NULL;
+    forbidden2Words = 0;
+}
+
+// find smallest color not used within distance 2 of v (uncolored vertices are
+// -1, so for the column/row graph of a matrix only other columns count)
+int get_color_d2(int v, int* result, Graph* g) {
+    // at most deg(v) + sum(deg(w) - 1) vertices sit within distance 2
+    long bound = DEGREE(g, v);
+    for(eid_t e = g->offsets[v]; e < g->offsets[v + 1]; e++) {
+        bound += DEGREE(g, g->adj[e]) - 1;
+    }
+    long words = bound / 64 + 1;
+    if (words > forbidden2Words) {
+        free(forbidden2);
+        forbidden2 = (uint64_t*) malloc(sizeof(uint64_t) * words);
+        forbidden2Words = words;
+    }
+    memset(forbidden2, 0, sizeof(uint64_t) * words);
+
+    // Mark colors used by neighbors and their neighbors
+    for(eid_t e = g->offsets[v]; e < g->offsets[v + 1]; e++) {
+        int w = g->adj[e];
+        int c = result[w];
+        if (c >= 0 && c <= bound) {
+            forbidden2[c >> 6] |= 1ULL << (c & 63);
+        }
+        for(eid_t f = g->offsets[w]; f < g->offsets[w + 1]; f++) {
+            int x = g->adj[f];
+            c = result[x];
+            if (x != v && c >= 0 && c <= bound) {
+                forbidden2[c >> 6] |= 1ULL << (c & 63);
+            }
+        }
+    }
+
+    for(long w = 0; w < words; w++) {
+        if (~forbidden2[w]) {
+            return (int) (w * 64 + __builtin_ctzll(~forbidden2[w]));
+        }
+    }
+    return -1;
+}
+
+// does u share its color with a lower id vertex within distance 2
+static int conflict_d2(int u, int* result, Graph* g) {
+    int c = result[u];
+    for(eid_t e = g->offsets[u]; e < g->offsets[u + 1]; e++) {
+        int w = g->adj[e];
+        if (w < u && result[w] == c) return 1;
+        for(eid_t f = g->offsets[w]; f < g->offsets[w + 1]; f++) {
+            int x = g->adj[f];
+            if (x < u && result[x] == c) return 1;
+        }
+    }
+    return 0;
+}
+
+// greedy coloring of the vertices one at a time in the given order
+int* sequentialGraph(Graph* g, const int* order) {
+    if (g->pending != NULL) {
+        finalizeGraph(g);
+    }
 
     int vert = g->nVertices;
+    int* result = (int *) malloc(sizeof(int) * vert);
+    for(int n = 0; n < vert; n++) {
+        result[n] = -1;
+    }
 
-    // Mark colors used by neighbors
     for(int i = 0; i < vert; i++) {
-        if(g->adjMatrix[v][i] == 1 && result[i] != -1) {
-            used_colors[result[i]] = 1;
+        int u = order ? order[i] : i;
+        result[u] = get_color(u, result, g);
+    }
+
+    free_color_scratch();
+    return result;
+}
+
+// Gebremedhin-Manne rounds over list[0..remaining): tentatively color the
+// worklist in parallel, then push only the vertices that ended up in conflict
+// (the higher id endpoint loses) to the next round. Vertices off the worklist
+// keep their color. Stops when the worklist runs empty, returns the rounds.
+// distance is '1' for a distance-1 coloring or '2' for distance 2, whose
+// vertices are handed out in smaller chunks as each one scans two hops.
+static int speculative_rounds(Graph* g, int* result, int* list, int remaining, char distance) {
+    int nThreads = omp_get_max_threads();
+    worklist queues[nThreads];
+    int starts[nThreads + 1];
+    memset(queues, 0, sizeof(queues));
+
+    // phase timings are only taken when instrumentation is on
+    int stats = color_stats.enabled;
+    double phase[3];
+    if (stats) {
+        stats_reset(nThreads);
+        #pragma omp parallel num_threads(nThreads)
+        stats_hw_start();
+    }
+    double tStart = CLOCK();
+    int chunk = (distance == '1') ? 1024 : 256;
+
+    int round = 0;
+    while (remaining > 0) {
+        #pragma omp parallel num_threads(nThreads)
+        {
+            int t = omp_get_thread_num();
+            worklist* q = &queues[t];
+            double busy = stats ? CLOCK() : 0.0;
+            q->n = 0;
+
+            // tentative coloring, reads of neighbors colored concurrently may be stale
+            #pragma omp for schedule(dynamic, chunk) nowait
+            for(int i = 0; i < remaining; i++) {
+                int u = list[i];
+                result[u] = (distance == '1') ? get_color(u, result, g) : get_color_d2(u, result, g);
+            }
+            if (stats) busy = CLOCK() - busy;
+            #pragma omp barrier
+            #pragma omp master
+            if (stats) phase[0] = CLOCK();
+
+            // only vertices colored this round can conflict with each other
+            double start = stats ? CLOCK() : 0.0;
+            #pragma omp for schedule(dynamic, chunk) nowait
+            for(int i = 0; i < remaining; i++) {
+                int u = list[i];
+                if ((distance == '1') ? lower_conflict(g, u, result) : conflict_d2(u, result, g)) {
+                    worklist_push(q, u);
+                }
+            }
+            if (stats) busy += CLOCK() - start;
+            #pragma omp barrier
+
+            // gather the per-thread queues into the next worklist
+            #pragma omp single
+            {
+                if (stats) phase[1] = CLOCK();
+                starts[0] = 0;
+                for(int b = 0; b < nThreads; b++) {
+                    starts[b + 1] = starts[b] + queues[b].n;
+                }
+            }
+            memcpy(list + starts[t], q->items, sizeof(int) * q->n);
+
+            if (stats && t < STATS_MAX_THREADS) {
+                color_stats.busy[t] += busy;
+            }
+        }
+
+        if (stats) {
+            int r = round < STATS_MAX_ROUNDS ? round : STATS_MAX_ROUNDS - 1;
+            phase[2] = CLOCK();
+            color_stats.colorTime[r] += phase[0] - tStart;
+            color_stats.detectTime[r] += phase[1] - phase[0];
+            color_stats.gatherTime[r] += phase[2] - phase[1];
+            color_stats.worklist[r] += remaining;
+            color_stats.conflicts[r] += starts[nThreads];
+            tStart = phase[2];
+        }
+
+        remaining = starts[nThreads];
+        round++;
+    }
+
+    #pragma omp parallel num_threads(nThreads)
+    {
+        if (distance == '1') {
+            free_color_scratch();
+        } else {
+            free_color_scratch_d2();
         }
+        if (stats) stats_hw_stop();
     }
 
-    // Find smallest available color
-    for(int c = 0; c < vert; c++) {
-        if(!used_colors[c]) return c;
+    if (stats) {
+        color_stats.rounds = round;
+        color_stats.totalTime = 0.0;
+        for(int r = 0; r < (round < STATS_MAX_ROUNDS ? round : STATS_MAX_ROUNDS); r++) {
+            color_stats.totalTime += color_stats.colorTime[r] + color_stats.detectTime[r] + color_stats.gatherTime[r];
+        }
     }
 
-    // should not return this
-    return -1; 
+    for(int t = 0; t < nThreads; t++) {
+        free(queues[t].items);
+    }
+    return round;
 }
 
-int* parallelGraph(Graph* g) {
+// Gebremedhin-Manne speculative coloring of the whole graph, see
+// speculative_rounds. The first round visits vertices in the given order
+// (NULL for id order).
+int* parallelGraph(Graph* g, const int* order, int* rounds) {
+    // graphs built with addEdge are turned into CSR on first use
+    if (g->pending != NULL) {
+        finalizeGraph(g);
+    }
+
     // check for base cases
     int vert = g->nVertices;
 
-    // dynamically allocate memory for result array
+    // dynamically allocate memory for result array and the worklist
     int* result = (int *) malloc(sizeof(int) * vert);
+    int* list = (int *) malloc(sizeof(int) * vert);
 
-    // initialize result to {-1}
+    // initialize result to {-1}, every vertex starts on the worklist
     #pragma omp parallel for
     for(int n = 0; n < vert; n++) {
         result[n] = -1;
+        list[n] = order ? order[n] : n;
+    }
+
+    int round = speculative_rounds(g, result, list, vert, '1');
+
+    free(list);
+    if (rounds) *rounds = round;
+    return result;
+}
+
+// Repair an existing coloring in place: the vertices found by
+// collect_conflicts are recolored with speculative rounds while every other
+// vertex keeps its color. Returns the number of vertices that were recolored.
+int repairColoring(Graph* g, int* result, int* rounds) {
+    if (g->pending != NULL) {
+        finalizeGraph(g);
+    }
+
+    int* list = (int*) malloc(sizeof(int) * (g->nVertices > 0 ? g->nVertices : 1));
+    int n = collect_conflicts(result, g, list);
+    int round = (n > 0) ? speculative_rounds(g, result, list, n, '1') : 0;
+
+    free(list);
+    if (rounds) *rounds = round;
+    return n;
+}
+
+// batch entry for one direction of an inserted or deleted edge
+typedef struct {
+    vid_t u;
+    vid_t v;
+    int insert;
+} edge_change;
+
+static int cmp_change(const void* a, const void* b) {
+    const edge_change* x = (const edge_change*) a;
+    const edge_change* y = (const edge_change*) b;
+    if (x->u != y->u) return (x->u > y->u) - (x->u < y->u);
+    return (x->v > y->v) - (x->v < y->v);
+}
+
+// Apply a batch of edge insertions and deletions to a finalized graph. Only
+// the rows of touched vertices are merged (in batch-sized work); the rest of
+// the CSR is moved into the new arrays with a parallel copy.
+void updateGraph(Graph* g, const Edge* inserted, int nInserted, const Edge* deleted, int nDeleted) {
+    int vert = g->nVertices;
+
+    // both directions of every change, sorted by source vertex
+    int nChanges = 0;
+    edge_change* changes = (edge_change*) malloc(sizeof(edge_change) * (2 * (nInserted + nDeleted) + 1));
+    for(int i = 0; i < nInserted + nDeleted; i++) {
+        const Edge* e = (i < nInserted) ? &inserted[i] : &deleted[i - nInserted];
+        if (e->u == e->v || e->u < 0 || e->v < 0 || e->u >= vert || e->v >= vert) continue;
+        changes[nChanges++] = (edge_change) { e->u, e->v, i < nInserted };
+        changes[nChanges++] = (edge_change) { e->v, e->u, i < nInserted };
+    }
+    qsort(changes, nChanges, sizeof(edge_change), cmp_change);
+
+    // find where each touched vertex's changes start
+    int nTouched = 0;
+    int* touched = (int*) malloc(sizeof(int) * (nChanges + 1));
+    for(int i = 0; i < nChanges; i++) {
+        if (i == 0 || changes[i].u != changes[i - 1].u) touched[nTouched++] = i;
     }
+    touched[nTouched] = nChanges;
+
+    // merge every touched row with its (sorted) changes into a private buffer
+    vid_t** rows = (vid_t**) malloc(sizeof(vid_t*) * (nTouched + 1));
+    eid_t* lens = (eid_t*) malloc(sizeof(eid_t) * (nTouched + 1));
+    #pragma omp parallel for schedule(dynamic, 16)
+    for(int k = 0; k < nTouched; k++) {
+        int u = changes[touched[k]].u;
+        const vid_t* old = g->adj + g->offsets[u];
+        eid_t oldLen = DEGREE(g, u);
+        int lo = touched[k];
+        int hi = touched[k + 1];
+        vid_t* row = (vid_t*) malloc(sizeof(vid_t) * (oldLen + (hi - lo) + 1));
+        eid_t n = 0;
+        eid_t i = 0;
+        int j = lo;
+
+        while (i < oldLen || j < hi) {
+            if (j >= hi || (i < oldLen && old[i] < changes[j].v)) {
+                row[n++] = old[i++];
+                continue;
+            }
 
-    #pragma omp parallel for 
+            // all changes to the same neighbor, the last one in batch order wins
+            vid_t v = changes[j].v;
+            int present = (i < oldLen && old[i] == v);
+            if (present) i++;
+            while (j < hi && changes[j].v == v) {
+                present = changes[j].insert;
+                j++;
+            }
+            if (present) row[n++] = v;
+        }
+        rows[k] = row;
+        lens[k] = n;
+    }
+
+    // new offsets: old degree everywhere except the touched rows
+    eid_t* offsets = (eid_t*) malloc(sizeof(eid_t) * (vert + 1));
+    offsets[0] = 0;
+    #pragma omp parallel for
     for(int u = 0; u < vert; u++) {
-        result[u] = get_color(u, result, g);
+        offsets[u + 1] = DEGREE(g, u);
+    }
+    for(int k = 0; k < nTouched; k++) {
+        offsets[changes[touched[k]].u + 1] = lens[k];
     }
+    prefix_sum(offsets, vert + 1);
 
-    while(conflicts_exist(result, g)) {
-        #pragma omp parallel for
+    vid_t* adj = (vid_t*) malloc(sizeof(vid_t) * (offsets[vert] > 0 ? offsets[vert] : 1));
+    #pragma omp parallel for schedule(dynamic, 1024)
+    for(int u = 0; u < vert; u++) {
+        memcpy(adj + offsets[u], g->adj + g->offsets[u], sizeof(vid_t) * (offsets[u + 1] - offsets[u]));
+    }
+    int maxDegree = 0;
+    #pragma omp parallel for reduction(max:maxDegree)
+    for(int k = 0; k < nTouched; k++) {
+        int u = changes[touched[k]].u;
+        memcpy(adj + offsets[u], rows[k], sizeof(vid_t) * lens[k]);
+        if (lens[k] > maxDegree) maxDegree = (int) lens[k];
+        free(rows[k]);
+    }
+
+    // deletions may lower the max degree, but it only bounds scratch sizes
+    free(g->offsets);
+    free(g->adj);
+    g->offsets = offsets;
+    g->adj = adj;
+    g->nEdges = offsets[vert] / 2;
+    if (maxDegree > g->maxDegree) g->maxDegree = maxDegree;
+
+    free(rows);
+    free(lens);
+    free(touched);
+    free(changes);
+}
+
+// Apply a batch of edge changes and repair an existing coloring in place.
+// Only the higher id endpoint of each inserted edge that now joins two equal
+// colors is recolored; with reclaim set, the endpoints of deleted edges are
+// recolored too so they can drop to lower colors. The repair runs the same
+// speculative rounds as parallelGraph over just those vertices, so its cost
+// follows the batch. Returns the number of vertices that were recolored.
+int recolorGraph(Graph* g, int* result, const Edge* inserted, int nInserted,
+                 const Edge* deleted, int nDeleted, int reclaim, int* rounds) {
+    updateGraph(g, inserted, nInserted, deleted, nDeleted);
+
+    int vert = g->nVertices;
+    int n = 0;
+    vid_t* list = (vid_t*) malloc(sizeof(vid_t) * (nInserted + 2 * nDeleted + 1));
+    for(int i = 0; i < nInserted; i++) {
+        int u = inserted[i].u;
+        int v = inserted[i].v;
+        if (u == v || u < 0 || v < 0 || u >= vert || v >= vert) continue;
+        if (result[u] == result[v]) list[n++] = (u > v) ? u : v;
+    }
+    if (reclaim) {
+        for(int i = 0; i < nDeleted; i++) {
+            int u = deleted[i].u;
+            int v = deleted[i].v;
+            if (u < 0 || v < 0 || u >= vert || v >= vert) continue;
+            list[n++] = u;
+            list[n++] = v;
+        }
+    }
+
+    // drop duplicates so no vertex is colored twice in a round
+    sort_ids(list, n);
+    int unique = 0;
+    for(int i = 0; i < n; i++) {
+        if (unique == 0 || list[i] != list[unique - 1]) list[unique++] = list[i];
+    }
+
+    int round = speculative_rounds(g, result, (int*) list, unique, '1');
+
+    free(list);
+    if (rounds) *rounds = round;
+    return unique;
+}
+
+// splitmix64 hash, gives every vertex a reproducible random priority
+uint64_t vertex_priority(uint64_t seed, int v) {
+    uint64_t z = seed + 0x9E3779B97F4A7C15ULL * ((uint64_t) v + 1);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+// does v come before u in the Jones-Plassmann order (ties go to the higher id)
+static inline int jp_before(const uint64_t* priority, int v, int u) {
+    return priority[v] > priority[u] || (priority[v] == priority[u] && v > u);
+}
+
+// gather the per-thread queues into list, called by every thread of the team
+// after its queue is complete; starts has room for nThreads + 1 entries
+static void gather_queues(worklist* queues, int nThreads, int* starts, int* list) {
+    int t = omp_get_thread_num();
+    #pragma omp barrier
+    #pragma omp single
+    {
+        starts[0] = 0;
+        for(int b = 0; b < nThreads; b++) {
+            starts[b + 1] = starts[b] + queues[b].n;
+        }
+    }
+    memcpy(list + starts[t], queues[t].items, sizeof(int) * queues[t].n);
+}
+
+// Jones-Plassmann coloring: a vertex is colored once every neighbor with a
+// higher priority is. Each vertex counts those neighbors once up front;
+// coloring a vertex decrements the counters of its lower priority neighbors,
+// and the ones that reach zero form the next round. A round is an
+// independent set, so no two of its vertices read each other's color and the
+// result only depends on the seed. Every edge is visited a constant number of
+// times, so the total work is O(V + E) however many rounds it takes. With a
+// rank (see orderVertices), higher ranks come first and the seed only breaks
+// ties within a rank.
+int* jonesPlassmannGraph(Graph* g, const uint32_t* rank, unsigned long seed, int* rounds) {
+    if (g->pending != NULL) {
+        finalizeGraph(g);
+    }
+
+    int vert = g->nVertices;
+    int* result = (int *) malloc(sizeof(int) * vert);
+    uint64_t* priority = (uint64_t *) malloc(sizeof(uint64_t) * vert);
+    int* waiting = (int *) malloc(sizeof(int) * vert);
+    int* frontier = (int *) malloc(sizeof(int) * (vert > 0 ? vert : 1));
+    int nThreads = omp_get_max_threads();
+    worklist queues[nThreads];
+    int starts[nThreads + 1];
+    memset(queues, 0, sizeof(queues));
+
+    #pragma omp parallel for
+    for(int n = 0; n < vert; n++) {
+        result[n] = -1;
+        priority[n] = vertex_priority(seed, n);
+        if (rank) {
+            priority[n] = ((uint64_t) rank[n] << 32) | (priority[n] >> 32);
+        }
+    }
+
+    // count the higher priority neighbors, vertices without any start
+    #pragma omp parallel num_threads(nThreads)
+    {
+        worklist* q = &queues[omp_get_thread_num()];
+        q->n = 0;
+
+        #pragma omp for schedule(dynamic, 1024) nowait
         for(int u = 0; u < vert; u++) {
-            for(int v = 0; v < vert; v++) {
-                if(g->adjMatrix[u][v] == 1 && result[u] == result[v]) {
-                    result[u] = get_color(u, result, g);
+            int count = 0;
+            for(eid_t e = g->offsets[u]; e < g->offsets[u + 1]; e++) {
+                count += jp_before(priority, g->adj[e], u);
+            }
+            waiting[u] = count;
+            if (count == 0) worklist_push(q, u);
+        }
+        gather_queues(queues, nThreads, starts, frontier);
+    }
+    int remaining = starts[nThreads];
+
+    int round = 0;
+    while (remaining > 0) {
+        #pragma omp parallel num_threads(nThreads)
+        {
+            worklist* q = &queues[omp_get_thread_num()];
+            q->n = 0;
+
+            // color the independent set and release the lower priority
+            // neighbors, a counter reaches zero exactly once
+            #pragma omp for schedule(dynamic, 256) nowait
+            for(int i = 0; i < remaining; i++) {
+                int u = frontier[i];
+                result[u] = get_color(u, result, g);
+                for(eid_t e = g->offsets[u]; e < g->offsets[u + 1]; e++) {
+                    int v = g->adj[e];
+                    int left;
+                    if (!jp_before(priority, u, v)) continue;
+                    #pragma omp atomic capture
+                    left = --waiting[v];
+                    if (left == 0) worklist_push(q, v);
                 }
             }
+            gather_queues(queues, nThreads, starts, frontier);
         }
+        remaining = starts[nThreads];
+        round++;
     }
 
+    #pragma omp parallel num_threads(nThreads)
+    free_color_scratch();
+
+    for(int t = 0; t < nThreads; t++) {
+        free(queues[t].items);
+    }
+    free(priority);
+    free(waiting);
+    free(frontier);
+    if (rounds) *rounds = round;
     return result;
 }
 
+// Distance-2 coloring of vertices [0, nColor) with the same speculate and
+// repair rounds as parallelGraph. With nColor = V this is a full distance-2
+// coloring. On the column/row graph from loadBipartite, passing the number of
+// columns gives a partial distance-2 coloring of the columns, which is the
+// column grouping used to compress a sparse Jacobian.
+int* distance2Graph(Graph* g, int nColor, const int* order, int* rounds) {
+    if (g->pending != NULL) {
+        finalizeGraph(g);
+    }
+
+    int vert = g->nVertices;
+    int* result = (int *) malloc(sizeof(int) * vert);
+    int* list = (int *) malloc(sizeof(int) * (nColor > 0 ? nColor : 1));
+
+    #pragma omp parallel for
+    for(int n = 0; n < vert; n++) {
+        result[n] = -1;
+    }
+
+    // keep only the colorable vertices of the order
+    int remaining = 0;
+    for(int i = 0; i < vert; i++) {
+        int u = order ? order[i] : i;
+        if (u < nColor) list[remaining++] = u;
+    }
+
+    int round = speculative_rounds(g, result, list, remaining, '2');
+
+    free(list);
+    if (rounds) *rounds = round;
+    return result;
+}
+
+// Function to check if a distance-2 conflict exists: around every vertex, the
+// vertex and its colored neighbors must all have different colors
+int conflicts_exist_d2(int *result, Graph* g) {
+    int vert = g->nVertices;
+    int maxColor = count_colors(result, vert);
+    int words = maxColor / 64 + 1;
+    int nChunks = (vert + CONFLICT_CHUNK - 1) / CONFLICT_CHUNK;
+    int conflict = 0;
+
+    // chunks with a shared stop flag, as in conflicts_exist
+    #pragma omp parallel
+    {
+        uint64_t* seen = (uint64_t*) calloc(words, sizeof(uint64_t));
+
+        #pragma omp for schedule(dynamic, 1)
+        for(int c = 0; c < nChunks; c++) {
+            int stop;
+            #pragma omp atomic read
+            stop = conflict;
+            if (stop) continue;
+
+            int end = (c + 1) * CONFLICT_CHUNK < vert ? (c + 1) * CONFLICT_CHUNK : vert;
+            for(int w = c * CONFLICT_CHUNK; w < end && !stop; w++) {
+                if (result[w] >= 0) {
+                    seen[result[w] >> 6] |= 1ULL << (result[w] & 63);
+                }
+                for(eid_t e = g->offsets[w]; e < g->offsets[w + 1]; e++) {
+                    int col = result[g->adj[e]];
+                    if (col < 0) continue;
+                    if (seen[col >> 6] & (1ULL << (col & 63))) {
+                        stop = 1;
+                    }
+                    seen[col >> 6] |= 1ULL << (col & 63);
+                }
+
+                // clear only the words touched so the check stays O(degree)
+                if (result[w] >= 0) {
+                    seen[result[w] >> 6] = 0;
+                }
+                for(eid_t e = g->offsets[w]; e < g->offsets[w + 1]; e++) {
+                    int col = result[g->adj[e]];
+                    if (col >= 0) seen[col >> 6] = 0;
+                }
+            }
+            if (stop) {
+                #pragma omp atomic write
+                conflict = 1;
+            }
+        }
+        free(seen);
+    }
+    return conflict;
+}
+
+// run the chosen algorithm; distance is '1', '2' or 'p' and only vertices
+// [0, nColor) are colored in the distance-2 modes. Jones-Plassmann takes the
+// rank from orderVertices instead of the order.
+int* colorGraph(Graph* g, color_alg alg, char distance, int nColor, const int* order,
+                const uint32_t* rank, unsigned long seed, int* rounds) {
+    *rounds = 1;
+    if (distance != '1') {
+        return distance2Graph(g, nColor, order, rounds);
+    } else if (alg == ALG_JP) {
+        return jonesPlassmannGraph(g, rank, seed, rounds);
+    } else if (alg == ALG_SEQUENTIAL) {
+        return sequentialGraph(g, order);
+    }
+    return parallelGraph(g, order, rounds);
+}
+
+// number of colors used by a coloring
+int count_colors(int* result, int n) {
+    int maxColor = -1;
+    #pragma omp parallel for reduction(max:maxColor)
+    for(int i = 0; i < n; i++) {
+        if (result[i] > maxColor) maxColor = result[i];
+    }
+    return maxColor + 1;
+}
+
+// build one of the two example graphs from the assignment
+void exampleGraph(Graph* graph, int which) {
+    if (which == 1) {
+        // Creating graph 1
+        initGraph(graph, 6);
+        addEdge(graph, 0, 4);
+        addEdge(graph, 0, 5);
+        addEdge(graph, 0, 2);
+
+        addEdge(graph, 1, 4);
+        addEdge(graph, 1, 5);
+
+        addEdge(graph, 2, 3);
+        addEdge(graph, 2, 4);
+
+        addEdge(graph, 5, 4);
+    } else {
+        // Creating graph 2
+        initGraph(graph, 8);
+        addEdge(graph, 0, 1);
+        addEdge(graph, 0, 2);
+        addEdge(graph, 0, 6);
+        addEdge(graph, 0, 7);
+
+        addEdge(graph, 1, 4);
+        addEdge(graph, 1, 5);
+        addEdge(graph, 1, 7);
+
+        addEdge(graph, 2, 3);
+        addEdge(graph, 2, 4);
+
+        addEdge(graph, 3, 4);
+        addEdge(graph, 3, 5);
+
+        addEdge(graph, 6, 7);
+    }
+    finalizeGraph(graph);
+}
+
+// write "vertex color" lines to a file
+int writeColors(const char* path, int* result, int n) {
+    FILE* fp = fopen(path, "w");
+    if (!fp) {
+        perror(path);
+        return -1;
+    }
+    for(int i = 0; i < n; i++) {
+        fprintf(fp, "%d %d\n", i, result[i]);
+    }
+    fclose(fp);
+    return 0;
+}
+
+// read "vertex color" lines as written by writeColors, vertices that are
+// missing or out of range stay uncolored (-1)
+int* readColors(const char* path, int n) {
+    FILE* fp = fopen(path, "r");
+    if (!fp) {
+        perror(path);
+        return NULL;
+    }
+    int* result = (int*) malloc(sizeof(int) * (n > 0 ? n : 1));
+    for(int i = 0; i < n; i++) {
+        result[i] = -1;
+    }
+    int v, c;
+    while (fscanf(fp, "%d %d", &v, &c) == 2) {
+        if (v >= 0 && v < n) result[v] = c;
+    }
+    fclose(fp);
+    return result;
+}
+
+// color_graph_mpi links these functions with its own main
+#ifndef COLOR_GRAPH_NO_MAIN
 int main(int argc, char** argv) {
     int opt;    // option int
-    int nThreads =  16; // default 5 philosophers
+    int nThreads =  16; // default 16 threads
+    int example = 2;    // example graph to use when no file is given
+    char* inFile = NULL;
+    char* genSpec = NULL;
+    char* outFile = NULL;
+    color_alg alg = ALG_SPECULATIVE;
+    unsigned long seed = 1;
+    vertex_order ord = ORDER_NATURAL;
+    char distance = '1';   // '1', '2' or 'p' for partial distance-2
+    relabel_kind relabel = RELABEL_NONE;
+    char* batchFile = NULL;
+    char* colorFile = NULL;
+    int reclaim = 0;
+    int bench = 0;
+    int dense = 0;
+    simd_level simd = simd_detect();
+    BenchConfig cfg;
+    memset(&cfg, 0, sizeof(cfg));
+    cfg.warmups = 1;
+    cfg.reps = 5;
 
     // get user arguments
-    while((opt = getopt(argc, argv, "t:h")) != -1) {
+    while((opt = getopt(argc, argv, "t:f:G:g:o:a:s:O:d:R:u:c:rS:DBT:A:w:n:F:PHh")) != -1) {
         int temp;
         switch (opt) {
             case 't':
                 temp = atoi(optarg);
-                if (temp < 0){
-                    printf("Invalid input for Number of Philosophers (Threads). Default: %d\n", nThreads);
+                if (temp <= 0){
+                    printf("Invalid input for Number of Threads. Default: %d\n", nThreads);
                 } else {
                     nThreads = temp;
                 }
                 break;
+            case 'f':
+                inFile = optarg;
+                break;
+            case 'G':
+                genSpec = optarg;
+                break;
+            case 'g':
+                temp = atoi(optarg);
+                if (temp != 1 && temp != 2) {
+                    printf("Invalid input for example graph. Default: %d\n", example);
+                } else {
+                    example = temp;
+                }
+                break;
+            case 'o':
+                outFile = optarg;
+                break;
+            case 'a':
+                if (strcmp(optarg, "spec") == 0) {
+                    alg = ALG_SPECULATIVE;
+                } else if (strcmp(optarg, "seq") == 0) {
+                    alg = ALG_SEQUENTIAL;
+                } else if (strcmp(optarg, "jp") == 0) {
+                    alg = ALG_JP;
+                } else {
+                    printf("Invalid input for algorithm. Default: spec\n");
+                }
+                break;
+            case 's':
+                seed = strtoul(optarg, NULL, 10);
+                break;
+            case 'd':
+                if (strcmp(optarg, "1") != 0 && strcmp(optarg, "2") != 0 && strcmp(optarg, "p") != 0) {
+                    printf("Invalid input for coloring distance. Default: 1\n");
+                } else {
+                    distance = optarg[0];
+                }
+                break;
+            case 'u':
+                batchFile = optarg;
+                break;
+            case 'c':
+                colorFile = optarg;
+                break;
+            case 'r':
+                reclaim = 1;
+                break;
+            case 'S':
+                if (parse_simd(optarg, &simd) != 0) {
+                    printf("Invalid input for instruction set. Default: auto\n");
+                    simd = simd_detect();
+                }
+                break;
+            case 'D':
+                dense = 1;
+                break;
+            case 'B':
+                bench = 1;
+                break;
+            case 'P':
+                color_stats.enabled = 1;
+                break;
+            case 'H':
+                color_stats.enabled = 1;
+                color_stats.hwCounters = 1;
+                break;
+            case 'T':
+                cfg.nThreads = parse_int_list(optarg, cfg.threads, BENCH_MAX_LIST);
+                if (cfg.nThreads <= 0) {
+                    printf("Invalid input for thread sweep. Default: powers of 2 up to -t\n");
+                    cfg.nThreads = 0;
+                }
+                break;
+            case 'A':
+                cfg.nAlgs = parse_alg_list(optarg, cfg.algs, BENCH_MAX_LIST);
+                if (cfg.nAlgs <= 0) {
+                    printf("Invalid input for algorithm sweep. Default: -a\n");
+                    cfg.nAlgs = 0;
+                }
+                break;
+            case 'w':
+                temp = atoi(optarg);
+                if (temp < 0) {
+                    printf("Invalid input for warmups. Default: %d\n", cfg.warmups);
+                } else {
+                    cfg.warmups = temp;
+                }
+                break;
+            case 'n':
+                temp = atoi(optarg);
+                if (temp <= 0) {
+                    printf("Invalid input for repetitions. Default: %d\n", cfg.reps);
+                } else {
+                    cfg.reps = temp;
+                }
+                break;
+            case 'F':
+                if (strcmp(optarg, "csv") == 0) {
+                    cfg.json = 0;
+                } else if (strcmp(optarg, "json") == 0) {
+                    cfg.json = 1;
+                } else {
+                    printf("Invalid input for report format. Default: csv\n");
+                }
+                break;
+            case 'R':
+                if (parse_relabel(optarg, &relabel) != 0) {
+                    printf("Invalid input for relabeling. Default: none\n");
+                }
+                break;
+            case 'O':
+                if (parse_order(optarg, &ord) != 0) {
+                    printf("Invalid input for vertex order. Default: natural\n");
+                }
+                break;
             case 'h':
-                printf("Usage: %s [-t threads] [-h]\n", argv[0]);
+                printf("Usage: %s [-t threads] [-f file] [-G spec] [-g 1|2] [-o file] [-a spec|jp|seq] [-s seed] [-O order] [-d 1|2|p] [-R relabel] [-u file] [-r] [-c file] [-S isa] [-D] [-P] [-H] [-h]\n", argv[0]);
+                printf("       %s -B [-T threads,...] [-A alg,...] [-w warmups] [-n reps] [-F csv|json] [-o file] graph...\n", argv[0]);
                 printf("  -t threads  Set the max number of threads\n");
+                printf("  -f file     Color a graph file (DIMACS .col, Matrix Market .mtx or edge list)\n");
+                printf("  -G spec     Color a generated graph: er:N,P | rmat:SCALE,EF[,A,B,C] | grid2d:X,Y\n");
+                printf("              | grid3d:X,Y,Z | geo:N,R (seeded by -s)\n");
+                printf("  -g graph    Color example graph 1 or 2 when no file is given\n");
+                printf("  -o file     Write the coloring as \"vertex color\" lines\n");
+                printf("  -a alg      Coloring algorithm (spec -> speculate and repair | jp -> Jones-Plassmann\n");
+                printf("              | seq -> sequential greedy)\n");
+                printf("  -s seed     Seed for the Jones-Plassmann priorities and the random order\n");
+                printf("  -O order    Vertex order (natural | random | lf -> largest first\n");
+                printf("              | sl -> smallest last | id -> incidence degree)\n");
+                printf("  -d dist     Coloring distance (1 | 2 | p -> partial distance-2 on the columns\n");
+                printf("              of the file read as a sparse matrix)\n");
+                printf("  -R relabel  Relabel vertices for locality before coloring (none | rcm | bfs | degree)\n");
+                printf("  -u file     After coloring, apply \"+ u v\" / \"- u v\" edge changes and repair the coloring\n");
+                printf("  -r          Also recolor endpoints of deleted edges to reclaim high colors\n");
+                printf("  -c file     Start from a coloring in \"vertex color\" lines and only repair its conflicts\n");
+                printf("  -S isa      Kernels for the neighbor scans (auto | scalar | avx2 | avx512)\n");
+                printf("  -D          Store the graph as a dense bit matrix (spec and seq, distance 1)\n");
+                printf("  -P          Print per-phase timings of the speculative rounds\n");
+                printf("  -H          Like -P, plus cache misses and instructions per thread (perf_event_open)\n");
+                printf("  -B          Benchmark mode, every graph argument is a file or a -G spec\n");
+                printf("  -T list     Thread counts to sweep (Default: powers of 2 up to -t)\n");
+                printf("  -A list     Algorithms to sweep (Default: -a)\n");
+                printf("  -w count    Untimed warmup runs per configuration (Default: 1)\n");
+                printf("  -n count    Timed repetitions per configuration (Default: 5)\n");
+                printf("  -F format   Benchmark report format (csv | json), written to -o or stdout\n");
                 printf("  -h          Display this help message\n");
                 return 0;
             default:
-                fprintf(stderr, "Usage: %s [-t threads] [-h]\n", argv[0]);
+                fprintf(stderr, "Usage: %s [-t threads] [-f file] [-G spec] [-g 1|2] [-o file] [-a spec|jp|seq] [-s seed] [-O order] [-d 1|2|p] [-R relabel] [-u file] [-r] [-c file] [-S isa] [-D] [-P] [-H] [-h]\n", argv[0]);
+                fprintf(stderr, "       %s -B [-T threads,...] [-A alg,...] [-w warmups] [-n reps] [-F csv|json] [-o file] graph...\n", argv[0]);
                 exit(EXIT_FAILURE);
         }
     }
     // Set max number of threads to use
     omp_set_num_threads(nThreads);
 
-    // // O(N^2) if color
-    // Graph graph;
-    // int vert = 6; // Number of vertices
-
-    // // Creating graph 1
-    // initGraph(&graph, vert);
-    // addEdge(&graph, 0, 4);
-    // addEdge(&graph, 0, 5);
-    // addEdge(&graph, 0, 2);
-
-    // addEdge(&graph, 1, 4);
-    // addEdge(&graph, 1, 5);
+    // falls back to the best instruction set the cpu has
+    simd = simd_select(simd);
 
-    // addEdge(&graph, 2, 3);
-    // addEdge(&graph, 2, 4);
+    // sweep thread counts and algorithms over the graph arguments
+    if (bench) {
+        if (optind >= argc) {
+            fprintf(stderr, "Benchmark mode needs at least one graph file or generator spec\n");
+            exit(EXIT_FAILURE);
+        }
+        if (cfg.nThreads == 0) {
+            for(int t = 1; t < nThreads && cfg.nThreads < BENCH_MAX_LIST - 1; t *= 2) {
+                cfg.threads[cfg.nThreads++] = t;
+            }
+            cfg.threads[cfg.nThreads++] = nThreads;
+        }
+        if (cfg.nAlgs == 0) {
+            cfg.algs[cfg.nAlgs++] = alg;
+        }
+        cfg.ord = ord;
+        cfg.seed = seed;
 
-    // addEdge(&graph, 5, 4);
+        FILE* report = stdout;
+        if (outFile && !(report = fopen(outFile, "w"))) {
+            perror(outFile);
+            exit(EXIT_FAILURE);
+        }
+        int status = runBenchmark(&cfg, argv + optind, argc - optind, report);
+        if (report != stdout) fclose(report);
+        return status == 0 ? 0 : EXIT_FAILURE;
+    }
 
-    // printf("Parallel Graph Coloring using OpenMP:\n");
-    // printf("Graph1(%d, %d):\n", graph.nVertices, graph.nEdges);
+    Graph graph;
+    double t1, total;
+    int nColumns = 0;   // columns of a matrix read for partial distance-2
 
-    // // benchmark start
-    // double t1, total;
-    // t1 = CLOCK();
+    printf("Parallel Graph Coloring using OpenMP:\n");
+    printf("Kernels: %s\n", simd_name(simd));
+    if (inFile) {
+        // benchmark the load separately from the coloring
+        t1 = CLOCK();
+        int status = (distance == 'p') ? loadBipartite(&graph, inFile, &nColumns) : loadGraph(&graph, inFile);
+        if (status != 0) {
+            exit(EXIT_FAILURE);
+        }
+        printf("%s(%d, %ld):\n", inFile, graph.nVertices, (long) graph.nEdges);
+        printf("Load time: %lf ms\n", CLOCK() - t1);
+    } else if (genSpec) {
+        t1 = CLOCK();
+        if (generateGraph(&graph, genSpec, seed) != 0) {
+            exit(EXIT_FAILURE);
+        }
+        printf("%s(%d, %ld):\n", genSpec, graph.nVertices, (long) graph.nEdges);
+        printf("Generate time: %lf ms\n", CLOCK() - t1);
+        if (distance == 'p') {
+            printf("Partial distance-2 needs a matrix file (-f), using distance 2\n");
+            distance = '2';
+        }
+    } else {
+        exampleGraph(&graph, example);
+        printf("Graph%d(%d, %ld):\n", example, graph.nVertices, (long) graph.nEdges);
+        if (distance == 'p') {
+            printf("Partial distance-2 needs a matrix file (-f), using distance 2\n");
+            distance = '2';
+        }
+    }
+    // only the columns are colored and reported in partial distance-2 mode
+    int vert = (distance == 'p') ? nColumns : graph.nVertices;
+    int rounds = 1;
+    int* result;
+    if (colorFile && distance != '1') {
+        printf("Repairing a coloring only supports distance-1 coloring, ignoring %s\n", colorFile);
+        colorFile = NULL;
+    }
+    if (colorFile) {
+        // the given coloring is repaired in place, so relabel and order do not apply
+        relabel = RELABEL_NONE;
+        ord = ORDER_NATURAL;
+    }
+    if (relabel != RELABEL_NONE && distance == 'p') {
+        printf("Relabeling would mix rows and columns in partial distance-2 mode, skipping\n");
+        relabel = RELABEL_NONE;
+    }
 
-    // int* result = parallelGraph(&graph);
+    // color a relabeled copy of the graph, the input ids are kept for the
+    // baseline timing, validation and output
+    Graph relabeled;
+    Graph* target = &graph;
+    int* perm = NULL;
+    double baseTime = 0.0;
+    if (relabel != RELABEL_NONE) {
+        t1 = CLOCK();
+        result = colorGraph(&graph, alg, distance, vert, NULL, NULL, seed, &rounds);
+        baseTime = CLOCK() - t1;
+        free(result);
 
-    // // benchmark stop
-    // total = CLOCK() - t1;
+        t1 = CLOCK();
+        perm = relabelOrder(&graph, relabel);
+        permuteGraph(&graph, perm, &relabeled);
+        printf("Relabel (%s) time: %lf ms\n", relabel_name(relabel), CLOCK() - t1);
+        target = &relabeled;
+    }
 
-    //  // print result
-    // for(int i = 0; i < vert; i++) {
-    //     printf("Node %d -> Color %d\n", i, result[i]);
-    // }
-    // printf("Time elapsed: %lf ms\n", total);
+    // the ordering is timed on its own so its cost can be weighed against the colors saved
+    int* order = NULL;
+    uint32_t* rank = NULL;
+    if (ord != ORDER_NATURAL) {
+        t1 = CLOCK();
+        order = orderVertices(target, ord, seed, &rank);
+        printf("Ordering (%s) time: %lf ms\n", order_name(ord), CLOCK() - t1);
+        if (alg == ALG_JP && distance == '1' && !rank) {
+            printf("Jones-Plassmann has no coarse key for the %s order, using the seeded priorities\n", order_name(ord));
+        }
+    }
 
-    // // free allocated memory
-    // deleteGraph(&graph);
-    // free(result);
-    
-    // Graph 2
-    Graph graph;
-    int vert = 8; // Number of vertices
+    // the ordering and relabeling above still need the CSR
+    if (dense && (distance != '1' || alg == ALG_JP)) {
+        printf("The dense bit matrix only supports spec and seq distance-1 coloring, keeping CSR\n");
+        dense = 0;
+    }
+    if (dense && batchFile) {
+        printf("Edge changes need the CSR, ignoring %s\n", batchFile);
+        batchFile = NULL;
+    }
+    if (dense) {
+        t1 = CLOCK();
+        denseGraph(target);
+        printf("Dense matrix (%.1f MB) time: %lf ms\n",
+               sizeof(uint64_t) * (double) target->rowWords * target->nVertices / (1 << 20), CLOCK() - t1);
+    }
 
-    // Creating graph 2
-    initGraph(&graph, vert);
-    addEdge(&graph, 0, 1);
-    addEdge(&graph, 0, 2);
-    addEdge(&graph, 0, 6);
-    addEdge(&graph, 0, 7);
+    if (colorFile) {
+        result = readColors(colorFile, vert);
+        if (!result) {
+            exit(EXIT_FAILURE);
+        }
 
-    addEdge(&graph, 1, 4);
-    addEdge(&graph, 1, 5);
-    addEdge(&graph, 1, 7);
+        // only the uncolored and conflicting vertices are recolored
+        t1 = CLOCK();
+        int repaired = repairColoring(target, result, &rounds);
+        total = CLOCK() - t1;
+        printf("Repaired vertices: %d\n", repaired);
+    } else {
+        // benchmark start
+        t1 = CLOCK();
 
-    addEdge(&graph, 2, 3);
-    addEdge(&graph, 2, 4);
+        result = colorGraph(target, alg, distance, vert, order, rank, seed, &rounds);
 
-    addEdge(&graph, 3, 4);
-    addEdge(&graph, 3, 5);
+        // benchmark stop
+        total = CLOCK() - t1;
+    }
 
-    addEdge(&graph, 6, 7);
+    if (color_stats.enabled && (alg == ALG_SPECULATIVE || distance != '1')) {
+        print_color_stats(stdout);
+    }
 
-    printf("Parallel Graph Coloring using OpenMP:\n");
-    printf("Graph2(%d, %d):\n", graph.nVertices, graph.nEdges);
+    // map colors back to the input ids
+    if (perm) {
+        int* mapped = (int*) malloc(sizeof(int) * vert);
+        #pragma omp parallel for
+        for(int i = 0; i < vert; i++) {
+            mapped[perm[i]] = result[i];
+        }
+        free(result);
+        result = mapped;
+        deleteGraph(&relabeled);
+        printf("Coloring time before relabel: %lf ms (speedup %0.2fx)\n", baseTime, baseTime / total);
+    }
 
-    // benchmark start
-    double t1, total;
-    t1 = CLOCK();
+    // print result, only the summary for loaded and generated graphs
+    if (!inFile && !genSpec) {
+        for(int i = 0; i < vert; i++) {
+            printf("Node %d -> Color %d\n", i, result[i]);
+        }
+        printf("Colors used: %d\n", count_colors(result, vert));
+    } else {
+        printf("Colors used: %d\n", count_colors(result, vert));
+        int invalid = (distance == '1') ? conflicts_exist(result, &graph) : conflicts_exist_d2(result, &graph);
+        printf("Valid: %s\n", invalid ? "no" : "yes");
+        printf("Rounds: %d\n", rounds);
+    }
+    printf("Time elapsed: %lf ms\n", total);
 
-    int* result = parallelGraph(&graph);
+    // repair the coloring after a batch of edge changes instead of starting over
+    if (batchFile) {
+        Edge* inserted;
+        Edge* deleted;
+        int nInserted, nDeleted;
+        if (distance != '1') {
+            printf("Incremental recoloring only supports distance-1 coloring, skipping %s\n", batchFile);
+        } else if (loadEdgeBatch(batchFile, &inserted, &nInserted, &deleted, &nDeleted) == 0) {
+            t1 = CLOCK();
+            int changed = recolorGraph(&graph, result, inserted, nInserted, deleted, nDeleted, reclaim, &rounds);
+            total = CLOCK() - t1;
 
-    // benchmark stop
-    total = CLOCK() - t1;
+            printf("Batch (%d inserted, %d deleted):\n", nInserted, nDeleted);
+            printf("Recolored vertices: %d\n", changed);
+            printf("Colors used: %d\n", count_colors(result, vert));
+            printf("Valid: %s\n", conflicts_exist(result, &graph) ? "no" : "yes");
+            printf("Rounds: %d\n", rounds);
+            printf("Time elapsed: %lf ms\n", total);
+            free(inserted);
+            free(deleted);
+        }
+    }
 
-     // print result
-    for(int i = 0; i < vert; i++) {
-        printf("Node %d -> Color %d\n", i, result[i]);
+    if (outFile && writeColors(outFile, result, vert) != 0) {
+        exit(EXIT_FAILURE);
     }
-    printf("Time elapsed: %lf ms\n", total);
 
     // free allocated memory
     deleteGraph(&graph);
+    free(order);
+    free(rank);
+    free(perm);
     free(result);
     return 0;
-}
\ No newline at end of file
+}
+#endif /*COLOR_GRAPH_NO_MAIN*/
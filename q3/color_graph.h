@@ -1,19 +1,82 @@
 #ifndef COLOR_GRAPH_H
 #define COLOR_GRAPH_H
 
+#include <stdint.h>
+
+// Vertex ids are always 32-bit. Edge offsets are 64-bit by default so graphs
+// with more than 2^31 adjacency entries fit; build with -DCSR_32BIT_OFFSETS
+// to halve the offset array when the graph is known to be small.
+typedef int32_t vid_t;
+#ifdef CSR_32BIT_OFFSETS
+typedef int32_t eid_t;
+#else
+typedef int64_t eid_t;
+#endif
+
+typedef struct {
+    vid_t u;
+    vid_t v;
+} Edge;
+
 typedef struct {
     int nVertices;      // The total number of vertices
-    int nEdges;         // Keep track of how many edges are in this graph 
-    int** adjMatrix;    // Dynamic matrix of adjacent vertices (allocated at runtime)
+    eid_t nEdges;       // Keep track of how many edges are in this graph
+    int maxDegree;      // Largest vertex degree (set when the CSR is built)
+    eid_t* offsets;     // CSR row offsets, neighbors of u are adj[offsets[u] .. offsets[u+1])
+    vid_t* adj;         // CSR neighbor array, each row sorted and free of duplicates
+
+    // Dense mode (denseGraph): one bit per matrix entry replaces the CSR
+    uint64_t* matrix;   // row u starts at matrix + u * rowWords, bit v set when u and v are adjacent
+    int rowWords;       // words per row, padded to a whole cache line
+
+    // Builder state: addEdge collects edges here until finalizeGraph
+    Edge* pending;      // Edge list waiting to be turned into CSR
+    eid_t nPending;     // Number of edges in the pending list
+    eid_t capPending;   // Allocated size of the pending list
 } Graph;
+
+typedef enum {
+    ALG_SPECULATIVE,    // color everything in parallel, then repair conflicts
+    ALG_JP,             // Jones-Plassmann independent set rounds
+    ALG_SEQUENTIAL      // one thread, greedy in vertex order
+} color_alg;
+
+// Degree of vertex u in a finalized graph
+#define DEGREE(g, u) ((int) ((g)->offsets[(u) + 1] - (g)->offsets[(u)]))
+
+// Row of vertex u in a dense graph
+#define DENSE_ROW(g, u) ((g)->matrix + (size_t) (u) * (g)->rowWords)
+
 double CLOCK();
 void initGraph(Graph* graph, int vertices);
 void addEdge(Graph *graph, int u, int v);
+void finalizeGraph(Graph* graph);
+void buildGraph(Graph* graph, int vertices, const Edge* edges, eid_t nEdges);
+void permuteGraph(Graph* g, const int* order, Graph* out);
 void deleteGraph(Graph* graph);
+void sort_ids(vid_t* a, eid_t len);
+uint64_t vertex_priority(uint64_t seed, int v);
 int isAdj(Graph* g, int u, int v);
 int conflicts_exist(int *result, Graph* g);
+int collect_conflicts(int* result, Graph* g, int* out);
 int get_color(int v, int* result, Graph* g);
-int* parallelGraph(Graph* g); 
+void free_color_scratch();
+int* sequentialGraph(Graph* g, const int* order);
+int* parallelGraph(Graph* g, const int* order, int* rounds);
+int repairColoring(Graph* g, int* result, int* rounds);
+void updateGraph(Graph* g, const Edge* inserted, int nInserted, const Edge* deleted, int nDeleted);
+int recolorGraph(Graph* g, int* result, const Edge* inserted, int nInserted,
+                 const Edge* deleted, int nDeleted, int reclaim, int* rounds);
+int* jonesPlassmannGraph(Graph* g, const uint32_t* rank, unsigned long seed, int* rounds);
+int get_color_d2(int v, int* result, Graph* g);
+int* distance2Graph(Graph* g, int nColor, const int* order, int* rounds);
+int conflicts_exist_d2(int *result, Graph* g);
+int* colorGraph(Graph* g, color_alg alg, char distance, int nColor, const int* order,
+                const uint32_t* rank, unsigned long seed, int* rounds);
+int count_colors(int* result, int n);
+void exampleGraph(Graph* graph, int which);
+int writeColors(const char* path, int* result, int n);
+int* readColors(const char* path, int n);
 
 
-#endif /*COLOR_GRAPH_H*/
\ No newline at end of file
+#endif /*COLOR_GRAPH_H*/
@@ -0,0 +1,693 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <unistd.h>
+#include <omp.h>
+#include <mpi.h>
+#include "color_graph.h"
+#include "color_mpi.h"
+#include "color_simd.h"
+#include "graph_io.h"
+#include "graph_gen.h"
+
+// contiguous blocks of ceil(n / ranks) vertices
+int blockOwner(int v, int nGlobal, int nRanks) {
+    int block = (nGlobal + nRanks - 1) / nRanks;
+    return block > 0 ? v / block : 0;
+}
+
+// read a partition file with the rank of vertex i on line i (the format
+// written by METIS and similar partitioners), NULL if it does not fit
+int* readPartition(const char* path, int nGlobal, int nRanks) {
+    FILE* fp = fopen(path, "r");
+    if (!fp) {
+        perror(path);
+        return NULL;
+    }
+    int* owner = (int*) malloc(sizeof(int) * (nGlobal > 0 ? nGlobal : 1));
+    int n = 0;
+    int bad = 0;
+    while (n < nGlobal && fscanf(fp, "%d", &owner[n]) == 1) {
+        if (owner[n] < 0 || owner[n] >= nRanks) {
+            fprintf(stderr, "%s: part %d of vertex %d is not a rank below %d\n", path, owner[n], n, nRanks);
+            bad = 1;
+            break;
+        }
+        n++;
+    }
+    fclose(fp);
+    if (!bad && n < nGlobal) {
+        fprintf(stderr, "%s: expected a part for each of the %d vertices\n", path, nGlobal);
+        bad = 1;
+    }
+    if (bad) {
+        free(owner);
+        return NULL;
+    }
+    return owner;
+}
+
+static int cmp_long(const void* a, const void* b) {
+    long x = *(const long*) a;
+    long y = *(const long*) b;
+    return (x > y) - (x < y);
+}
+
+// owner rank of global vertex v, a NULL owner array means contiguous blocks
+static int owner_of(const int* owner, int v, int nGlobal, int nRanks) {
+    return owner ? owner[v] : blockOwner(v, nGlobal, nRanks);
+}
+
+// MPI counts and displacements are ints, a rank that would send or receive
+// more than INT_MAX ints (about 536M edges) stops the run
+static void check_route_size(long total, const char* what) {
+    if (total > INT_MAX) {
+        int rank;
+        MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+        fprintf(stderr, "rank %d: %ld ints to %s do not fit MPI int counts, use more ranks\n", rank, total, what);
+        MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+    }
+}
+
+// Send both directions of every edge in edges[0..nEdges) to the rank owning
+// their first endpoint, self loops are dropped. Returns the pairs this rank
+// received, all with a local first endpoint.
+static Edge* route_edges(const Edge* edges, eid_t nEdges, const int* owner, int nGlobal, int nRanks, eid_t* nRecv) {
+    long* sendLong = (long*) calloc(nRanks, sizeof(long));
+    int* sendCnt = (int*) calloc(nRanks, sizeof(int));
+    int* recvCnt = (int*) malloc(sizeof(int) * nRanks);
+    int* sendDispl = (int*) malloc(sizeof(int) * nRanks);
+    int* recvDispl = (int*) malloc(sizeof(int) * nRanks);
+
+    // counts are in ints, two per directed edge
+    for(eid_t e = 0; e < nEdges; e++) {
+        if (edges[e].u == edges[e].v) continue;
+        sendLong[owner_of(owner, edges[e].u, nGlobal, nRanks)] += 2;
+        sendLong[owner_of(owner, edges[e].v, nGlobal, nRanks)] += 2;
+    }
+    long sendTotal = 0;
+    for(int r = 0; r < nRanks; r++) {
+        sendTotal += sendLong[r];
+    }
+    check_route_size(sendTotal, "send");
+    for(int r = 0, displ = 0; r < nRanks; r++) {
+        sendCnt[r] = (int) sendLong[r];
+        sendDispl[r] = displ;
+        displ += sendCnt[r];
+    }
+    free(sendLong);
+
+    int* sendBuf = (int*) malloc(sizeof(int) * (sendTotal > 0 ? sendTotal : 1));
+    int* cursor = (int*) malloc(sizeof(int) * nRanks);
+    memcpy(cursor, sendDispl, sizeof(int) * nRanks);
+    for(eid_t e = 0; e < nEdges; e++) {
+        int u = edges[e].u;
+        int v = edges[e].v;
+        if (u == v) continue;
+        int ru = owner_of(owner, u, nGlobal, nRanks);
+        int rv = owner_of(owner, v, nGlobal, nRanks);
+        sendBuf[cursor[ru]++] = u;
+        sendBuf[cursor[ru]++] = v;
+        sendBuf[cursor[rv]++] = v;
+        sendBuf[cursor[rv]++] = u;
+    }
+    free(cursor);
+
+    MPI_Alltoall(sendCnt, 1, MPI_INT, recvCnt, 1, MPI_INT, MPI_COMM_WORLD);
+    long recvTotal = 0;
+    for(int r = 0; r < nRanks; r++) {
+        recvTotal += recvCnt[r];
+    }
+    check_route_size(recvTotal, "receive");
+    for(int r = 0, displ = 0; r < nRanks; r++) {
+        recvDispl[r] = displ;
+        displ += recvCnt[r];
+    }
+    Edge* recv = (Edge*) malloc(sizeof(int) * (recvTotal > 0 ? recvTotal : 2));
+    MPI_Alltoallv(sendBuf, sendCnt, sendDispl, MPI_INT, (int*) recv, recvCnt, recvDispl, MPI_INT, MPI_COMM_WORLD);
+
+    free(sendCnt);
+    free(recvCnt);
+    free(sendDispl);
+    free(recvDispl);
+    free(sendBuf);
+    *nRecv = recvTotal / 2;
+    return recv;
+}
+
+// local index of global vertex v owned by rank r; the locals and every ghost
+// group are sorted by global id, so this is a binary search
+static int local_index(const DistGraph* d, int v, int r, int rank) {
+    int lo = (r == rank) ? 0 : d->nLocal + d->recvOffsets[r];
+    int hi = (r == rank) ? d->nLocal : lo + d->recvCounts[r];
+    while (lo < hi) {
+        int mid = lo + (hi - lo) / 2;
+        if (d->globalId[mid] < v) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+// Build this rank's share of a distributed graph from the edges it parsed or
+// generated (any part of the edge list). Both directions of every edge go to
+// the owner of their first endpoint, so each rank gets the full rows of its
+// own vertices and never holds the rest of the graph. Ghosts are the
+// neighbors in those rows owned by other ranks, and the boundary colors to
+// send are worked out from the same rows. Every rank builds the same lists
+// from its side: the ghosts this rank holds of rank r are exactly the
+// vertices r sends here, both sorted by global id. A NULL owner array means
+// contiguous blocks (blockOwner).
+void distributeEdges(const Edge* edges, eid_t nEdges, int nGlobal, const int* owner,
+                     int rank, int nRanks, DistGraph* d) {
+    int n = nGlobal;
+    eid_t nRecv;
+    Edge* recv = route_edges(edges, nEdges, owner, n, nRanks, &nRecv);
+
+    // locals in increasing global id
+    int nLocal = 0;
+    int first = 0;
+    if (owner) {
+        for(int v = 0; v < n; v++) {
+            nLocal += (owner[v] == rank);
+        }
+    } else {
+        int block = (n + nRanks - 1) / nRanks;
+        first = block * rank < n ? block * rank : n;
+        nLocal = (first + block < n ? first + block : n) - first;
+    }
+
+    // ghosts sorted by (owner, global id)
+    long* keys = (long*) malloc(sizeof(long) * (nRecv > 0 ? nRecv : 1));
+    eid_t nKeys = 0;
+    for(eid_t e = 0; e < nRecv; e++) {
+        int w = recv[e].v;
+        int r = owner_of(owner, w, n, nRanks);
+        if (r != rank) keys[nKeys++] = (long) r * n + w;
+    }
+    qsort(keys, nKeys, sizeof(long), cmp_long);
+    int nGhost = 0;
+    for(eid_t k = 0; k < nKeys; k++) {
+        if (nGhost == 0 || keys[k] != keys[nGhost - 1]) keys[nGhost++] = keys[k];
+    }
+
+    int total = nLocal + nGhost;
+    d->nGlobal = n;
+    d->nLocal = nLocal;
+    d->nGhost = nGhost;
+    d->nRanks = nRanks;
+    d->globalId = (int*) malloc(sizeof(int) * (total > 0 ? total : 1));
+    d->recvCounts = (int*) calloc(nRanks, sizeof(int));
+    d->recvOffsets = (int*) calloc(nRanks + 1, sizeof(int));
+    d->sendCounts = (int*) calloc(nRanks, sizeof(int));
+    d->sendOffsets = (int*) calloc(nRanks + 1, sizeof(int));
+
+    if (owner) {
+        for(int v = 0, i = 0; v < n; v++) {
+            if (owner[v] == rank) d->globalId[i++] = v;
+        }
+    } else {
+        for(int i = 0; i < nLocal; i++) {
+            d->globalId[i] = first + i;
+        }
+    }
+    for(int k = 0; k < nGhost; k++) {
+        int w = (int) (keys[k] % n);
+        d->globalId[nLocal + k] = w;
+        d->recvCounts[keys[k] / n]++;
+    }
+    free(keys);
+    for(int r = 0; r < nRanks; r++) {
+        d->recvOffsets[r + 1] = d->recvOffsets[r] + d->recvCounts[r];
+    }
+
+    // local CSR in local indices, ghost rows stay empty; the received pairs
+    // are renamed in place, then rows are sorted and deduplicated
+    Graph* l = &d->local;
+    memset(l, 0, sizeof(Graph));
+    l->nVertices = total;
+    l->offsets = (eid_t*) calloc(total + 1, sizeof(eid_t));
+    #pragma omp parallel for
+    for(eid_t e = 0; e < nRecv; e++) {
+        int v = recv[e].v;
+        recv[e].u = local_index(d, recv[e].u, rank, rank);
+        recv[e].v = local_index(d, v, owner_of(owner, v, n, nRanks), rank);
+    }
+    for(eid_t e = 0; e < nRecv; e++) {
+        l->offsets[recv[e].u + 1]++;
+    }
+    for(int u = 0; u < total; u++) {
+        l->offsets[u + 1] += l->offsets[u];
+    }
+    eid_t* cursor = (eid_t*) malloc(sizeof(eid_t) * (total + 1));
+    memcpy(cursor, l->offsets, sizeof(eid_t) * (total + 1));
+    vid_t* adj = (vid_t*) malloc(sizeof(vid_t) * (nRecv > 0 ? nRecv : 1));
+    for(eid_t e = 0; e < nRecv; e++) {
+        adj[cursor[recv[e].u]++] = recv[e].v;
+    }
+    free(recv);
+
+    // the new row lengths go in cursor[u + 1]
+    cursor[0] = 0;
+    #pragma omp parallel for schedule(dynamic, 1024)
+    for(int u = 0; u < total; u++) {
+        vid_t* row = adj + l->offsets[u];
+        eid_t len = l->offsets[u + 1] - l->offsets[u];
+        eid_t k = 0;
+        sort_ids(row, len);
+        for(eid_t i = 0; i < len; i++) {
+            if (k == 0 || row[i] != row[k - 1]) row[k++] = row[i];
+        }
+        cursor[u + 1] = k;
+    }
+    for(int u = 0; u < total; u++) {
+        cursor[u + 1] += cursor[u];
+    }
+    l->adj = (vid_t*) malloc(sizeof(vid_t) * (cursor[total] > 0 ? cursor[total] : 1));
+    int maxDegree = 0;
+    #pragma omp parallel for schedule(dynamic, 1024) reduction(max:maxDegree)
+    for(int u = 0; u < total; u++) {
+        eid_t len = cursor[u + 1] - cursor[u];
+        memcpy(l->adj + cursor[u], adj + l->offsets[u], sizeof(vid_t) * len);
+        if (len > maxDegree) maxDegree = (int) len;
+    }
+    free(adj);
+    free(l->offsets);
+    l->offsets = cursor;
+    l->maxDegree = maxDegree;
+    l->nEdges = l->offsets[total];
+
+    // a boundary vertex is sent once to every rank that owns a neighbor,
+    // lastSent keeps it from being listed twice for the same rank
+    int* lastSent = (int*) malloc(sizeof(int) * nRanks);
+    for(int pass = 0; pass < 2; pass++) {
+        int* next = (int*) malloc(sizeof(int) * nRanks);
+        for(int r = 0; r < nRanks; r++) {
+            lastSent[r] = -1;
+            next[r] = d->sendOffsets[r];
+        }
+        for(int u = 0; u < nLocal; u++) {
+            for(eid_t e = l->offsets[u]; e < l->offsets[u + 1]; e++) {
+                int w = l->adj[e];
+                if (w < nLocal) continue;
+                int r = owner_of(owner, d->globalId[w], n, nRanks);
+                if (lastSent[r] == u) continue;
+                lastSent[r] = u;
+                if (pass == 0) {
+                    d->sendCounts[r]++;
+                } else {
+                    d->sendList[next[r]++] = u;
+                }
+            }
+        }
+        free(next);
+        if (pass == 0) {
+            for(int r = 0; r < nRanks; r++) {
+                d->sendOffsets[r + 1] = d->sendOffsets[r] + d->sendCounts[r];
+            }
+            d->sendList = (int*) malloc(sizeof(int) * (d->sendOffsets[nRanks] > 0 ? d->sendOffsets[nRanks] : 1));
+        }
+    }
+    free(lastSent);
+}
+
+void deleteDistGraph(DistGraph* d) {
+    deleteGraph(&d->local);
+    free(d->globalId);
+    free(d->sendCounts);
+    free(d->sendOffsets);
+    free(d->sendList);
+    free(d->recvCounts);
+    free(d->recvOffsets);
+}
+
+// Send the colors of the boundary vertices colored in this round to the ranks
+// holding ghosts of them, one batch per rank as (position in the send list,
+// color) pairs, and mark the updated ghosts with the round.
+static void exchange_colors(DistGraph* d, int* colors, int* mark, int round) {
+    int nRanks = d->nRanks;
+    int* sendCnt = (int*) calloc(nRanks, sizeof(int));
+    int* recvCnt = (int*) malloc(sizeof(int) * nRanks);
+    int* sendDispl = (int*) malloc(sizeof(int) * nRanks);
+    int* recvDispl = (int*) malloc(sizeof(int) * nRanks);
+    int* sendBuf = (int*) malloc(sizeof(int) * 2 * (d->sendOffsets[nRanks] > 0 ? d->sendOffsets[nRanks] : 1));
+
+    int pos = 0;
+    for(int r = 0; r < nRanks; r++) {
+        sendDispl[r] = pos;
+        for(int k = 0; k < d->sendCounts[r]; k++) {
+            int u = d->sendList[d->sendOffsets[r] + k];
+            if (mark[u] != round) continue;
+            sendBuf[pos++] = k;
+            sendBuf[pos++] = colors[u];
+        }
+        sendCnt[r] = pos - sendDispl[r];
+    }
+
+    MPI_Alltoall(sendCnt, 1, MPI_INT, recvCnt, 1, MPI_INT, MPI_COMM_WORLD);
+    int recvTotal = 0;
+    for(int r = 0; r < nRanks; r++) {
+        recvDispl[r] = recvTotal;
+        recvTotal += recvCnt[r];
+    }
+    int* recvBuf = (int*) malloc(sizeof(int) * (recvTotal > 0 ? recvTotal : 1));
+    MPI_Alltoallv(sendBuf, sendCnt, sendDispl, MPI_INT, recvBuf, recvCnt, recvDispl, MPI_INT, MPI_COMM_WORLD);
+
+    for(int r = 0; r < nRanks; r++) {
+        for(int i = recvDispl[r]; i < recvDispl[r] + recvCnt[r]; i += 2) {
+            int ghost = d->nLocal + d->recvOffsets[r] + recvBuf[i];
+            colors[ghost] = recvBuf[i + 1];
+            mark[ghost] = round;
+        }
+    }
+
+    free(sendCnt);
+    free(recvCnt);
+    free(sendDispl);
+    free(recvDispl);
+    free(sendBuf);
+    free(recvBuf);
+}
+
+// Distributed speculative coloring. Every round each rank colors its worklist
+// with OpenMP threads against the ghost colors it knows, exchanges the new
+// boundary colors, and keeps only the vertices that lost a conflict: a vertex
+// loses to a neighbor of the same color that kept its color from an earlier
+// round, or that was colored in the same round and has a lower global id.
+// Ranks on both sides of a boundary edge see the same colors after the
+// exchange, so they agree on the loser without further messages. Returns the
+// colors of the locals and ghosts, stops when no rank has work left.
+int* distributedGraph(DistGraph* d, int* rounds) {
+    int total = d->nLocal + d->nGhost;
+    int* colors = (int*) malloc(sizeof(int) * (total > 0 ? total : 1));
+    int* mark = (int*) malloc(sizeof(int) * (total > 0 ? total : 1));
+    int* list = (int*) malloc(sizeof(int) * (d->nLocal > 0 ? d->nLocal : 1));
+    char* lose = (char*) malloc(d->nLocal > 0 ? d->nLocal : 1);
+
+    for(int u = 0; u < total; u++) {
+        colors[u] = -1;
+        mark[u] = -1;
+    }
+    int remaining = d->nLocal;
+    for(int u = 0; u < remaining; u++) {
+        list[u] = u;
+    }
+
+    int round = 0;
+    int global = 0;
+    MPI_Allreduce(&remaining, &global, 1, MPI_INT, MPI_SUM, MPI_COMM_WORLD);
+    while (global > 0) {
+        Graph* l = &d->local;
+
+        #pragma omp parallel
+        {
+            #pragma omp for schedule(dynamic, 1024)
+            for(int i = 0; i < remaining; i++) {
+                int u = list[i];
+                colors[u] = get_color(u, colors, l);
+                mark[u] = round;
+            }
+            free_color_scratch();
+        }
+
+        exchange_colors(d, colors, mark, round);
+
+        #pragma omp parallel for schedule(dynamic, 1024)
+        for(int i = 0; i < remaining; i++) {
+            int u = list[i];
+            lose[i] = 0;
+            for(eid_t e = l->offsets[u]; e < l->offsets[u + 1]; e++) {
+                int v = l->adj[e];
+                if (colors[v] == colors[u] && (mark[v] != round || d->globalId[v] < d->globalId[u])) {
+                    lose[i] = 1;
+                    break;
+                }
+            }
+        }
+
+        int next = 0;
+        for(int i = 0; i < remaining; i++) {
+            if (lose[i]) list[next++] = list[i];
+        }
+        remaining = next;
+        round++;
+        MPI_Allreduce(&remaining, &global, 1, MPI_INT, MPI_SUM, MPI_COMM_WORLD);
+    }
+
+    free(mark);
+    free(list);
+    free(lose);
+    if (rounds) *rounds = round;
+    return colors;
+}
+
+// 1 on every rank if any rank has a local vertex sharing its color with a
+// local or ghost neighbor; ghost colors are current after distributedGraph
+int distributedConflicts(DistGraph* d, const int* colors) {
+    Graph* l = &d->local;
+    int conflict = 0;
+    #pragma omp parallel for reduction(|:conflict) schedule(dynamic, 1024)
+    for(int u = 0; u < d->nLocal; u++) {
+        for(eid_t e = l->offsets[u]; e < l->offsets[u + 1]; e++) {
+            if (colors[l->adj[e]] == colors[u]) conflict |= 1;
+        }
+    }
+    int any = 0;
+    MPI_Allreduce(&conflict, &any, 1, MPI_INT, MPI_LOR, MPI_COMM_WORLD);
+    return any;
+}
+
+int main(int argc, char** argv) {
+    int opt;    // option int
+    int nThreads = 1;   // default 1 thread per rank
+    int example = 2;    // example graph to use when no file is given
+    char* inFile = NULL;
+    char* genSpec = NULL;
+    char* partFile = NULL;
+    char* outFile = NULL;
+    unsigned long seed = 1;
+    simd_level simd = simd_detect();
+
+    // MPI is only called outside of the OpenMP regions
+    int provided;
+    MPI_Init_thread(&argc, &argv, MPI_THREAD_FUNNELED, &provided);
+    int rank, nRanks;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &nRanks);
+
+    // get user arguments
+    while((opt = getopt(argc, argv, "t:f:G:g:p:o:s:S:h")) != -1) {
+        int temp;
+        switch (opt) {
+            case 't':
+                temp = atoi(optarg);
+                if (temp <= 0){
+                    if (rank == 0) printf("Invalid input for Number of Threads. Default: %d\n", nThreads);
+                } else {
+                    nThreads = temp;
+                }
+                break;
+            case 'f':
+                inFile = optarg;
+                break;
+            case 'G':
+                genSpec = optarg;
+                break;
+            case 'g':
+                temp = atoi(optarg);
+                if (temp != 1 && temp != 2) {
+                    if (rank == 0) printf("Invalid input for example graph. Default: %d\n", example);
+                } else {
+                    example = temp;
+                }
+                break;
+            case 'p':
+                partFile = optarg;
+                break;
+            case 'o':
+                outFile = optarg;
+                break;
+            case 's':
+                seed = strtoul(optarg, NULL, 10);
+                break;
+            case 'S':
+                if (parse_simd(optarg, &simd) != 0) {
+                    if (rank == 0) printf("Invalid input for instruction set. Default: auto\n");
+                    simd = simd_detect();
+                }
+                break;
+            case 'h':
+                if (rank == 0) {
+                    printf("Usage: mpirun -np ranks %s [-t threads] [-f file] [-G spec] [-g 1|2] [-p file] [-o file] [-s seed] [-S isa] [-h]\n", argv[0]);
+                    printf("  -t threads  Set the number of OpenMP threads per rank\n");
+                    printf("  -f file     Color a graph file (DIMACS .col, Matrix Market .mtx or edge list)\n");
+                    printf("  -G spec     Color a generated graph, same specs as color_graph (seeded by -s)\n");
+                    printf("  -g graph    Color example graph 1 or 2 when no file is given\n");
+                    printf("  -p file     Vertex partition, the rank of vertex i on line i (Default: blocks)\n");
+                    printf("  -o file     Write the coloring as \"vertex color\" lines\n");
+                    printf("  -s seed     Seed for the generated graph\n");
+                    printf("  -S isa      Kernels for the neighbor scans (auto | scalar | avx2 | avx512)\n");
+                    printf("  -h          Display this help message\n");
+                }
+                MPI_Finalize();
+                return 0;
+            default:
+                if (rank == 0) {
+                    fprintf(stderr, "Usage: mpirun -np ranks %s [-t threads] [-f file] [-G spec] [-g 1|2] [-p file] [-o file] [-s seed] [-S isa] [-h]\n", argv[0]);
+                }
+                MPI_Finalize();
+                exit(EXIT_FAILURE);
+        }
+    }
+    omp_set_num_threads(nThreads);
+    simd = simd_select(simd);
+
+    // every rank parses or generates its own part of the edge list, the
+    // edges are then sent to the ranks owning their endpoints
+    Edge* edges = NULL;
+    eid_t nPart = 0;
+    long nVertices = 0;
+    double t1 = MPI_Wtime();
+    int status = 0;
+    if (inFile) {
+        status = loadEdgeRange(inFile, rank, nRanks, &edges, &nPart, &nVertices);
+    } else if (genSpec) {
+        int nGen = 0;
+        status = generateEdges(genSpec, seed, rank, nRanks, &edges, &nPart, &nGen);
+        nVertices = nGen;
+    } else {
+        // the example graphs are tiny, rank 0 hands out all of their edges
+        Graph example_graph;
+        exampleGraph(&example_graph, example);
+        edges = (Edge*) malloc(sizeof(Edge) * (example_graph.nEdges > 0 ? example_graph.nEdges : 1));
+        for(int u = 0; rank == 0 && u < example_graph.nVertices; u++) {
+            for(eid_t e = example_graph.offsets[u]; e < example_graph.offsets[u + 1]; e++) {
+                if (u < example_graph.adj[e]) {
+                    edges[nPart].u = u;
+                    edges[nPart++].v = example_graph.adj[e];
+                }
+            }
+        }
+        nVertices = example_graph.nVertices;
+        deleteGraph(&example_graph);
+    }
+    if (status != 0) {
+        MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+    }
+
+    // an edge list only knows its largest id once every part is read
+    long allVertices = 0;
+    MPI_Allreduce(&nVertices, &allVertices, 1, MPI_LONG, MPI_MAX, MPI_COMM_WORLD);
+    if (allVertices > INT32_MAX) {
+        if (rank == 0) fprintf(stderr, "%ld vertices do not fit 32-bit vertex ids\n", allVertices);
+        MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+    }
+    int n = (int) allVertices;
+
+    // a partition file is read by every rank, blocks need no table
+    int* owner = NULL;
+    if (partFile) {
+        owner = readPartition(partFile, n, nRanks);
+        if (!owner) {
+            MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+        }
+    }
+
+    DistGraph dist;
+    distributeEdges(edges, nPart, n, owner, rank, nRanks, &dist);
+    free(edges);
+    free(owner);
+    double loadTime = MPI_Wtime() - t1;
+
+    // every edge sits in the rows of both its endpoints
+    long rowEntries = (long) dist.local.offsets[dist.nLocal], nEdges = 0;
+    MPI_Allreduce(&rowEntries, &nEdges, 1, MPI_LONG, MPI_SUM, MPI_COMM_WORLD);
+    nEdges /= 2;
+
+    long ghosts = dist.nGhost, allGhosts = 0;
+    MPI_Reduce(&ghosts, &allGhosts, 1, MPI_LONG, MPI_SUM, 0, MPI_COMM_WORLD);
+
+    // benchmark start
+    int rounds = 0;
+    MPI_Barrier(MPI_COMM_WORLD);
+    t1 = MPI_Wtime();
+
+    int* colors = distributedGraph(&dist, &rounds);
+
+    // benchmark stop
+    double total = (MPI_Wtime() - t1) * 1000.0;
+
+    int maxColor = -1, globalMax = -1;
+    for(int u = 0; u < dist.nLocal; u++) {
+        if (colors[u] > maxColor) maxColor = colors[u];
+    }
+    MPI_Allreduce(&maxColor, &globalMax, 1, MPI_INT, MPI_MAX, MPI_COMM_WORLD);
+    int invalid = distributedConflicts(&dist, colors);
+
+    // gather (global id, color) pairs on rank 0 for the output file
+    if (outFile) {
+        int* pairs = (int*) malloc(sizeof(int) * 2 * (dist.nLocal > 0 ? dist.nLocal : 1));
+        for(int u = 0; u < dist.nLocal; u++) {
+            pairs[2 * u] = dist.globalId[u];
+            pairs[2 * u + 1] = colors[u];
+        }
+        int count = 2 * dist.nLocal;
+        int* counts = NULL;
+        int* displs = NULL;
+        int* all = NULL;
+        if (rank == 0) {
+            counts = (int*) malloc(sizeof(int) * nRanks);
+            displs = (int*) malloc(sizeof(int) * nRanks);
+        }
+        MPI_Gather(&count, 1, MPI_INT, counts, 1, MPI_INT, 0, MPI_COMM_WORLD);
+        if (rank == 0) {
+            int sum = 0;
+            for(int r = 0; r < nRanks; r++) {
+                displs[r] = sum;
+                sum += counts[r];
+            }
+            all = (int*) malloc(sizeof(int) * (sum > 0 ? sum : 1));
+        }
+        MPI_Gatherv(pairs, count, MPI_INT, all, counts, displs, MPI_INT, 0, MPI_COMM_WORLD);
+        if (rank == 0) {
+            int* result = (int*) malloc(sizeof(int) * (n > 0 ? n : 1));
+            for(int i = 0; i < 2 * n; i += 2) {
+                result[all[i]] = all[i + 1];
+            }
+            if (writeColors(outFile, result, n) != 0) {
+                MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+            }
+            free(result);
+        }
+        free(pairs);
+        free(counts);
+        free(displs);
+        free(all);
+    }
+
+    if (rank == 0) {
+        printf("Distributed Graph Coloring using MPI + OpenMP:\n");
+        printf("Ranks: %d, threads per rank: %d, kernels: %s\n", nRanks, nThreads, simd_name(simd));
+        if (inFile) {
+            printf("%s(%d, %ld):\n", inFile, n, nEdges);
+        } else if (genSpec) {
+            printf("%s(%d, %ld):\n", genSpec, n, nEdges);
+        } else {
+            printf("Graph%d(%d, %ld):\n", example, n, nEdges);
+        }
+        printf("Partition: %s, ghost vertices: %ld\n", partFile ? partFile : "blocks", allGhosts);
+        printf("Load and distribute time: %lf ms\n", loadTime * 1000.0);
+        printf("Colors used: %d\n", globalMax + 1);
+        printf("Valid: %s\n", invalid ? "no" : "yes");
+        printf("Rounds: %d\n", rounds);
+        printf("Time elapsed: %lf ms\n", total);
+    }
+
+    free(colors);
+    deleteDistGraph(&dist);
+    MPI_Finalize();
+    return 0;
+}
@@ -0,0 +1,31 @@
+#ifndef COLOR_MPI_H
+#define COLOR_MPI_H
+
+#include "color_graph.h"
+
+// One rank's share of a distributed graph. Local vertices come first, then
+// ghost copies of neighbors owned by other ranks, grouped by owner rank and
+// sorted by global id inside each group.
+typedef struct {
+    Graph local;        // CSR over locals and ghosts, ghost rows are empty
+    int nGlobal;        // vertices in the whole graph
+    int nLocal;         // vertices owned by this rank
+    int nGhost;         // neighbors owned by other ranks
+    int* globalId;      // global id of every local and ghost vertex
+    int nRanks;
+    int* sendCounts;    // boundary vertices each rank keeps a ghost copy of
+    int* sendOffsets;
+    int* sendList;      // local indices grouped by rank, sorted by global id
+    int* recvCounts;    // ghosts owned by each rank
+    int* recvOffsets;   // ghost k of rank r is nLocal + recvOffsets[r] + k
+} DistGraph;
+
+int blockOwner(int v, int nGlobal, int nRanks);
+int* readPartition(const char* path, int nGlobal, int nRanks);
+void distributeEdges(const Edge* edges, eid_t nEdges, int nGlobal, const int* owner,
+                     int rank, int nRanks, DistGraph* d);
+void deleteDistGraph(DistGraph* d);
+int* distributedGraph(DistGraph* d, int* rounds);
+int distributedConflicts(DistGraph* d, const int* colors);
+
+#endif /*COLOR_MPI_H*/
@@ -0,0 +1,216 @@
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include "color_simd.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define HAVE_X86 1
+#endif
+
+static int find_color_scalar(const vid_t* adj, eid_t n, const int* result, int color) {
+    for(eid_t i = 0; i < n; i++) {
+        if (result[adj[i]] == color) return 1;
+    }
+    return 0;
+}
+
+static void mark_colors_scalar(const vid_t* adj, eid_t n, const int* result, int limit, uint64_t* bits) {
+    for(eid_t i = 0; i < n; i++) {
+        int c = result[adj[i]];
+        // the unsigned compare also drops uncolored (-1) neighbors
+        if ((unsigned) c <= (unsigned) limit) {
+            bits[c >> 6] |= 1ULL << (c & 63);
+        }
+    }
+}
+
+static int first_free_scalar(const uint64_t* bits, int words) {
+    for(int w = 0; w < words; w++) {
+        if (~bits[w]) {
+            return w * 64 + __builtin_ctzll(~bits[w]);
+        }
+    }
+    return -1;
+}
+
+#ifdef HAVE_X86
+
+// shorter neighbor lists are left to the scalar loops, the gathers only pay
+// off once there are a few full vectors of neighbors
+#define SIMD_MIN_ROW 64
+
+// AVX2: 8 neighbor colors per gather, 4 bitset words per compare
+
+__attribute__((target("avx2")))
+static int find_color_avx2(const vid_t* adj, eid_t n, const int* result, int color) {
+    if (n < SIMD_MIN_ROW) return find_color_scalar(adj, n, result, color);
+    __m256i target = _mm256_set1_epi32(color);
+    eid_t i = 0;
+    for(; i + 8 <= n; i += 8) {
+        __m256i idx = _mm256_loadu_si256((const __m256i*) (adj + i));
+        __m256i c = _mm256_i32gather_epi32(result, idx, 4);
+        if (_mm256_movemask_epi8(_mm256_cmpeq_epi32(c, target))) return 1;
+    }
+    return find_color_scalar(adj + i, n - i, result, color);
+}
+
+__attribute__((target("avx2")))
+static void mark_colors_avx2(const vid_t* adj, eid_t n, const int* result, int limit, uint64_t* bits) {
+    if (n < SIMD_MIN_ROW) {
+        mark_colors_scalar(adj, n, result, limit, bits);
+        return;
+    }
+    __m256i bias = _mm256_set1_epi32(INT32_MIN);
+    __m256i max = _mm256_set1_epi32(limit ^ INT32_MIN);
+    int colors[8];
+    eid_t i = 0;
+    for(; i + 8 <= n; i += 8) {
+        __m256i idx = _mm256_loadu_si256((const __m256i*) (adj + i));
+        __m256i c = _mm256_i32gather_epi32(result, idx, 4);
+        // unsigned c <= limit, done as a signed compare on biased values
+        __m256i over = _mm256_cmpgt_epi32(_mm256_xor_si256(c, bias), max);
+        unsigned mask = ~_mm256_movemask_ps(_mm256_castsi256_ps(over)) & 0xFF;
+        _mm256_storeu_si256((__m256i*) colors, c);
+        while (mask) {
+            int l = __builtin_ctz(mask);
+            bits[colors[l] >> 6] |= 1ULL << (colors[l] & 63);
+            mask &= mask - 1;
+        }
+    }
+    mark_colors_scalar(adj + i, n - i, result, limit, bits);
+}
+
+__attribute__((target("avx2")))
+static int first_free_avx2(const uint64_t* bits, int words) {
+    __m256i full = _mm256_set1_epi64x(-1);
+    int w = 0;
+    for(; w + 4 <= words; w += 4) {
+        __m256i v = _mm256_loadu_si256((const __m256i*) (bits + w));
+        int mask = _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(v, full)));
+        if (mask != 0xF) {
+            int k = w + __builtin_ctz(~mask & 0xF);
+            return k * 64 + __builtin_ctzll(~bits[k]);
+        }
+    }
+    int rest = first_free_scalar(bits + w, words - w);
+    return rest < 0 ? -1 : w * 64 + rest;
+}
+
+// AVX-512: 16 neighbor colors per gather, 8 bitset words per compare
+
+__attribute__((target("avx512f")))
+static int find_color_avx512(const vid_t* adj, eid_t n, const int* result, int color) {
+    if (n < SIMD_MIN_ROW) return find_color_scalar(adj, n, result, color);
+    __m512i target = _mm512_set1_epi32(color);
+    eid_t i = 0;
+    for(; i + 16 <= n; i += 16) {
+        __m512i idx = _mm512_loadu_si512((const void*) (adj + i));
+        __m512i c = _mm512_i32gather_epi32(idx, result, 4);
+        if (_mm512_cmpeq_epi32_mask(c, target)) return 1;
+    }
+    return find_color_scalar(adj + i, n - i, result, color);
+}
+
+__attribute__((target("avx512f")))
+static void mark_colors_avx512(const vid_t* adj, eid_t n, const int* result, int limit, uint64_t* bits) {
+    if (n < SIMD_MIN_ROW) {
+        mark_colors_scalar(adj, n, result, limit, bits);
+        return;
+    }
+    __m512i max = _mm512_set1_epi32(limit);
+    int colors[16];
+    eid_t i = 0;
+    for(; i + 16 <= n; i += 16) {
+        __m512i idx = _mm512_loadu_si512((const void*) (adj + i));
+        __m512i c = _mm512_i32gather_epi32(idx, result, 4);
+        // keep only the colors in [0, limit], packed to the front
+        __mmask16 keep = _mm512_cmple_epu32_mask(c, max);
+        _mm512_mask_compressstoreu_epi32(colors, keep, c);
+        int k = __builtin_popcount(keep);
+        for(int l = 0; l < k; l++) {
+            bits[colors[l] >> 6] |= 1ULL << (colors[l] & 63);
+        }
+    }
+    mark_colors_scalar(adj + i, n - i, result, limit, bits);
+}
+
+__attribute__((target("avx512f")))
+static int first_free_avx512(const uint64_t* bits, int words) {
+    __m512i full = _mm512_set1_epi64(-1);
+    int w = 0;
+    for(; w + 8 <= words; w += 8) {
+        __m512i v = _mm512_loadu_si512((const void*) (bits + w));
+        __mmask8 open = _mm512_cmpneq_epu64_mask(v, full);
+        if (open) {
+            int k = w + __builtin_ctz(open);
+            return k * 64 + __builtin_ctzll(~bits[k]);
+        }
+    }
+    int rest = first_free_avx2(bits + w, words - w);
+    return rest < 0 ? -1 : w * 64 + rest;
+}
+
+#endif
+
+ColorKernels color_simd = { SIMD_SCALAR, find_color_scalar, mark_colors_scalar, first_free_scalar };
+
+// parse "scalar", "avx2", "avx512" or "auto" (best supported), 0 on success
+int parse_simd(const char* s, simd_level* out) {
+    if (strcmp(s, "scalar") == 0) {
+        *out = SIMD_SCALAR;
+    } else if (strcmp(s, "avx2") == 0) {
+        *out = SIMD_AVX2;
+    } else if (strcmp(s, "avx512") == 0) {
+        *out = SIMD_AVX512;
+    } else if (strcmp(s, "auto") == 0) {
+        *out = simd_detect();
+    } else {
+        return -1;
+    }
+    return 0;
+}
+
+const char* simd_name(simd_level level) {
+    switch (level) {
+        case SIMD_AVX2:   return "avx2";
+        case SIMD_AVX512: return "avx512";
+        default:          return "scalar";
+    }
+}
+
+// best instruction set the cpu supports
+simd_level simd_detect() {
+#ifdef HAVE_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) return SIMD_AVX512;
+    if (__builtin_cpu_supports("avx2")) return SIMD_AVX2;
+#endif
+    return SIMD_SCALAR;
+}
+
+// switch the kernels to the given level, or the best one below it the cpu
+// supports; returns the level in use
+simd_level simd_select(simd_level level) {
+    simd_level best = simd_detect();
+    if (level > best) level = best;
+
+    color_simd.level = SIMD_SCALAR;
+    color_simd.find_color = find_color_scalar;
+    color_simd.mark_colors = mark_colors_scalar;
+    color_simd.first_free = first_free_scalar;
+#ifdef HAVE_X86
+    if (level == SIMD_AVX2) {
+        color_simd.level = SIMD_AVX2;
+        color_simd.find_color = find_color_avx2;
+        color_simd.mark_colors = mark_colors_avx2;
+        color_simd.first_free = first_free_avx2;
+    } else if (level == SIMD_AVX512) {
+        color_simd.level = SIMD_AVX512;
+        color_simd.find_color = find_color_avx512;
+        color_simd.mark_colors = mark_colors_avx512;
+        color_simd.first_free = first_free_avx512;
+    }
+#endif
+    return color_simd.level;
+}
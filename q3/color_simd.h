@@ -0,0 +1,32 @@
+#ifndef COLOR_SIMD_H
+#define COLOR_SIMD_H
+
+#include <stdint.h>
+#include "color_graph.h"
+
+typedef enum {
+    SIMD_SCALAR,
+    SIMD_AVX2,
+    SIMD_AVX512
+} simd_level;
+
+// Kernels for the neighbor scans of get_color and the conflict checks. They
+// point at the scalar versions until simd_select picks a vector instruction set.
+typedef struct {
+    simd_level level;
+    // 1 if any of the n neighbors in adj has the given color
+    int (*find_color)(const vid_t* adj, eid_t n, const int* result, int color);
+    // set bit c in bits for every neighbor color c with 0 <= c <= limit
+    void (*mark_colors)(const vid_t* adj, eid_t n, const int* result, int limit, uint64_t* bits);
+    // index of the first zero bit in bits[0..words), -1 if there is none
+    int (*first_free)(const uint64_t* bits, int words);
+} ColorKernels;
+
+extern ColorKernels color_simd;
+
+int parse_simd(const char* s, simd_level* out);
+const char* simd_name(simd_level level);
+simd_level simd_detect();
+simd_level simd_select(simd_level level);
+
+#endif /*COLOR_SIMD_H*/
@@ -0,0 +1,125 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#include <omp.h>
+#include "color_stats.h"
+
+ColorStats color_stats;
+
+// per-thread counter file descriptors, -1 when not open
+static __thread int missFd = -1;
+static __thread int instrFd = -1;
+
+// clear the counters of the previous run, keeping the enable flags
+void stats_reset(int nThreads) {
+    int enabled = color_stats.enabled;
+    int hw = color_stats.hwCounters;
+    memset(&color_stats, 0, sizeof(color_stats));
+    color_stats.enabled = enabled;
+    color_stats.hwCounters = hw;
+    color_stats.nThreads = nThreads < STATS_MAX_THREADS ? nThreads : STATS_MAX_THREADS;
+    color_stats.hwAvailable = hw;
+}
+
+static int open_counter(unsigned long long config) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = config;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+
+    // pid 0, cpu -1: count the calling thread on whatever cpu it runs
+    return (int) syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+// open and enable the calling thread's counters, call from inside the team
+void stats_hw_start() {
+    if (!color_stats.enabled || !color_stats.hwCounters) return;
+
+    missFd = open_counter(PERF_COUNT_HW_CACHE_MISSES);
+    instrFd = open_counter(PERF_COUNT_HW_INSTRUCTIONS);
+    if (missFd < 0 || instrFd < 0) {
+        #pragma omp atomic write
+        color_stats.hwAvailable = 0;
+        return;
+    }
+    ioctl(missFd, PERF_EVENT_IOC_RESET, 0);
+    ioctl(instrFd, PERF_EVENT_IOC_RESET, 0);
+    ioctl(missFd, PERF_EVENT_IOC_ENABLE, 0);
+    ioctl(instrFd, PERF_EVENT_IOC_ENABLE, 0);
+}
+
+// read and close the calling thread's counters
+void stats_hw_stop() {
+    int t = omp_get_thread_num();
+    long long value;
+
+    if (missFd >= 0) {
+        if (t < STATS_MAX_THREADS && read(missFd, &value, sizeof(value)) == sizeof(value)) {
+            color_stats.cacheMisses[t] = value;
+        }
+        close(missFd);
+        missFd = -1;
+    }
+    if (instrFd >= 0) {
+        if (t < STATS_MAX_THREADS && read(instrFd, &value, sizeof(value)) == sizeof(value)) {
+            color_stats.instructions[t] = value;
+        }
+        close(instrFd);
+        instrFd = -1;
+    }
+}
+
+// print the summary of the last run
+void print_color_stats(FILE* out) {
+    ColorStats* s = &color_stats;
+    int shown = s->rounds < STATS_MAX_ROUNDS ? s->rounds : STATS_MAX_ROUNDS;
+    double colorTotal = 0.0, detectTotal = 0.0, gatherTotal = 0.0;
+    for(int r = 0; r < shown; r++) {
+        colorTotal += s->colorTime[r];
+        detectTotal += s->detectTime[r];
+        gatherTotal += s->gatherTime[r];
+    }
+
+    fprintf(out, "------ Coloring Phases ------\n");
+    fprintf(out, "Threads: %d\n", s->nThreads);
+    fprintf(out, "Rounds: %d\n", s->rounds);
+    fprintf(out, "Total: %0.3f ms\n", s->totalTime);
+    fprintf(out, "Initial color: %0.3f ms\n", shown > 0 ? s->colorTime[0] : 0.0);
+    fprintf(out, "Conflict detect: %0.3f ms\n", detectTotal);
+    fprintf(out, "Repair rounds: %0.3f ms\n", colorTotal - (shown > 0 ? s->colorTime[0] : 0.0));
+    fprintf(out, "Worklist gather: %0.3f ms\n", gatherTotal);
+
+    fprintf(out, "%-6s %12s %12s %10s %10s %10s\n", "round", "worklist", "conflicts", "color_ms", "detect_ms", "gather_ms");
+    for(int r = 0; r < shown; r++) {
+        fprintf(out, "%-6d %12ld %12ld %10.3f %10.3f %10.3f\n", r + 1, s->worklist[r], s->conflicts[r],
+                s->colorTime[r], s->detectTime[r], s->gatherTime[r]);
+    }
+    if (s->rounds > shown) {
+        fprintf(out, "(rounds %d-%d are added into round %d)\n", STATS_MAX_ROUNDS, s->rounds, STATS_MAX_ROUNDS);
+    }
+
+    fprintf(out, "%-6s %10s %10s", "thread", "busy_ms", "idle_ms");
+    if (s->hwCounters && s->hwAvailable) {
+        fprintf(out, " %14s %14s", "cache_misses", "instructions");
+    }
+    fprintf(out, "\n");
+    for(int t = 0; t < s->nThreads; t++) {
+        double idle = s->totalTime - s->busy[t];
+        fprintf(out, "%-6d %10.3f %10.3f", t, s->busy[t], idle > 0.0 ? idle : 0.0);
+        if (s->hwCounters && s->hwAvailable) {
+            fprintf(out, " %14lld %14lld", s->cacheMisses[t], s->instructions[t]);
+        }
+        fprintf(out, "\n");
+    }
+    if (s->hwCounters && !s->hwAvailable) {
+        fprintf(out, "Hardware counters: unavailable (perf_event_open failed)\n");
+    }
+}
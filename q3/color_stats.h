@@ -0,0 +1,35 @@
+#ifndef COLOR_STATS_H
+#define COLOR_STATS_H
+
+#include <stdio.h>
+
+#define STATS_MAX_ROUNDS 64     // rounds past this are folded into the last slot
+#define STATS_MAX_THREADS 256
+
+// Instrumentation of the speculative coloring rounds, filled in by
+// speculative_rounds when enabled is set
+typedef struct {
+    int enabled;                            // collect timings and counts
+    int hwCounters;                         // also read perf_event_open counters
+    int nThreads;                           // threads in the last run
+    int rounds;                             // rounds in the last run
+    double totalTime;                       // wall time of all rounds (ms)
+    double colorTime[STATS_MAX_ROUNDS];     // tentative coloring phase per round (ms)
+    double detectTime[STATS_MAX_ROUNDS];    // conflict detection phase per round (ms)
+    double gatherTime[STATS_MAX_ROUNDS];    // building the next worklist per round (ms)
+    long worklist[STATS_MAX_ROUNDS];        // vertices colored in the round
+    long conflicts[STATS_MAX_ROUNDS];       // vertices pushed to the next round
+    double busy[STATS_MAX_THREADS];         // time each thread spent in loop bodies (ms)
+    int hwAvailable;                        // counters could be opened on every thread
+    long long cacheMisses[STATS_MAX_THREADS];
+    long long instructions[STATS_MAX_THREADS];
+} ColorStats;
+
+extern ColorStats color_stats;
+
+void stats_reset(int nThreads);
+void stats_hw_start();
+void stats_hw_stop();
+void print_color_stats(FILE* out);
+
+#endif /*COLOR_STATS_H*/
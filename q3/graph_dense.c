@@ -0,0 +1,114 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <omp.h>
+#include "graph_dense.h"
+
+// words per 64 byte cache line
+#define LINE_WORDS 8
+
+// Turn a finalized CSR graph into a dense one: a single cache line aligned
+// bit matrix with one row per vertex, each row padded to whole cache lines.
+// The CSR is freed, so the graph takes V * V / 8 bytes from here on.
+void denseGraph(Graph* g) {
+    if (g->pending != NULL) {
+        finalizeGraph(g);
+    }
+
+    int vert = g->nVertices;
+    int rowWords = (vert + 63) / 64;
+    rowWords = (rowWords + LINE_WORDS - 1) / LINE_WORDS * LINE_WORDS;
+    if (rowWords == 0) rowWords = LINE_WORDS;
+
+    size_t bytes = sizeof(uint64_t) * rowWords * (size_t) (vert > 0 ? vert : 1);
+    uint64_t* matrix = (uint64_t*) aligned_alloc(64, bytes);
+    if (!matrix) {
+        fprintf(stderr, "Could not allocate a %zu byte adjacency matrix\n", bytes);
+        exit(EXIT_FAILURE);
+    }
+
+    // every thread only writes the rows it owns, so no atomics are needed
+    #pragma omp parallel for schedule(dynamic, 64)
+    for(int u = 0; u < vert; u++) {
+        uint64_t* row = matrix + (size_t) u * rowWords;
+        memset(row, 0, sizeof(uint64_t) * rowWords);
+        for(eid_t e = g->offsets[u]; e < g->offsets[u + 1]; e++) {
+            vid_t v = g->adj[e];
+            row[v >> 6] |= 1ULL << (v & 63);
+        }
+    }
+
+    free(g->offsets);
+    free(g->adj);
+    g->offsets = NULL;
+    g->adj = NULL;
+    g->matrix = matrix;
+    g->rowWords = rowWords;
+}
+
+// set bit c in bits for the color c of every neighbor of v with 0 <= c <= limit
+void dense_mark_colors(Graph* g, int v, const int* result, int limit, uint64_t* bits) {
+    const uint64_t* row = DENSE_ROW(g, v);
+    for(int w = 0; w < g->rowWords; w++) {
+        uint64_t word = row[w];
+        while (word) {
+            int c = result[w * 64 + __builtin_ctzll(word)];
+            if ((unsigned) c <= (unsigned) limit) {
+                bits[c >> 6] |= 1ULL << (c & 63);
+            }
+            word &= word - 1;
+        }
+    }
+}
+
+// 1 if a neighbor of u with an id below the given bound has the given color
+int dense_find_color(Graph* g, int u, const int* result, int color, int below) {
+    const uint64_t* row = DENSE_ROW(g, u);
+    int words = (below + 63) / 64;
+    for(int w = 0; w < words; w++) {
+        uint64_t word = row[w];
+        // drop the columns at or past the bound in the last word
+        if (w == words - 1 && (below & 63)) {
+            word &= (1ULL << (below & 63)) - 1;
+        }
+        while (word) {
+            if (result[w * 64 + __builtin_ctzll(word)] == color) return 1;
+            word &= word - 1;
+        }
+    }
+    return 0;
+}
+
+// One bit row per color class (row 0 holds the uncolored vertices, row c + 1
+// color c), so a vertex conflicts when its row ANDed with its own class is not
+// empty. Returns NULL when the classes would not be smaller than the matrix,
+// then the neighbor scan of dense_find_color is the better check.
+uint64_t* dense_color_classes(Graph* g, const int* result) {
+    int vert = g->nVertices;
+    int nClasses = count_colors((int*) result, vert) + 1;
+    if (nClasses >= vert) return NULL;
+
+    uint64_t* classes = (uint64_t*) aligned_alloc(64, sizeof(uint64_t) * g->rowWords * (size_t) nClasses);
+    if (!classes) return NULL;
+    memset(classes, 0, sizeof(uint64_t) * g->rowWords * (size_t) nClasses);
+
+    #pragma omp parallel for
+    for(int u = 0; u < vert; u++) {
+        int k = result[u] < 0 ? 0 : result[u] + 1;
+        #pragma omp atomic
+        classes[(size_t) k * g->rowWords + (u >> 6)] |= 1ULL << (u & 63);
+    }
+    return classes;
+}
+
+// 1 if u has a neighbor in its own color class
+int dense_class_conflict(Graph* g, int u, const int* result, const uint64_t* classes) {
+    const uint64_t* row = DENSE_ROW(g, u);
+    int k = result[u] < 0 ? 0 : result[u] + 1;
+    const uint64_t* same = classes + (size_t) k * g->rowWords;
+    uint64_t any = 0;
+    for(int w = 0; w < g->rowWords; w++) {
+        any |= row[w] & same[w];
+    }
+    return any != 0;
+}
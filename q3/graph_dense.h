@@ -0,0 +1,13 @@
+#ifndef GRAPH_DENSE_H
+#define GRAPH_DENSE_H
+
+#include <stdint.h>
+#include "color_graph.h"
+
+void denseGraph(Graph* g);
+void dense_mark_colors(Graph* g, int v, const int* result, int limit, uint64_t* bits);
+int dense_find_color(Graph* g, int u, const int* result, int color, int below);
+uint64_t* dense_color_classes(Graph* g, const int* result);
+int dense_class_conflict(Graph* g, int u, const int* result, const uint64_t* classes);
+
+#endif /*GRAPH_DENSE_H*/
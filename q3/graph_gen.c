@@ -0,0 +1,311 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <omp.h>
+#include "graph_gen.h"
+
+// per-thread edge list filled by the generators
+typedef struct {
+    Edge* edges;
+    eid_t n;
+    eid_t cap;
+} edge_buffer;
+
+static void buffer_push(edge_buffer* b, vid_t u, vid_t v) {
+    if (b->n == b->cap) {
+        b->cap = b->cap ? b->cap * 2 : 4096;
+        b->edges = (Edge*) realloc(b->edges, sizeof(Edge) * b->cap);
+    }
+    b->edges[b->n].u = u;
+    b->edges[b->n].v = v;
+    b->n++;
+}
+
+// concatenate the per-thread buffers into one edge list
+static Edge* gather_buffers(edge_buffer* bufs, int nBufs, eid_t* nEdges) {
+    eid_t offsets[nBufs + 1];
+    offsets[0] = 0;
+    for(int i = 0; i < nBufs; i++) {
+        offsets[i + 1] = offsets[i] + bufs[i].n;
+    }
+
+    Edge* edges = (Edge*) malloc(sizeof(Edge) * (offsets[nBufs] > 0 ? offsets[nBufs] : 1));
+    #pragma omp parallel for num_threads(nBufs) schedule(static, 1)
+    for(int i = 0; i < nBufs; i++) {
+        memcpy(edges + offsets[i], bufs[i].edges, sizeof(Edge) * bufs[i].n);
+        free(bufs[i].edges);
+    }
+    *nEdges = offsets[nBufs];
+    return edges;
+}
+
+// build the CSR of an n vertex graph from an edge list and free the list
+static void build_from_edges(Graph* g, int n, Edge* edges, eid_t nEdges) {
+    buildGraph(g, n, edges, nEdges);
+    free(edges);
+}
+
+// splitmix64 step, every row / edge / point gets its own stream from the
+// seed so the generated graph does not depend on the number of threads
+static uint64_t next_rand(uint64_t* state) {
+    uint64_t z = (*state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+// uniform double in [0, 1)
+static double next_uniform(uint64_t* state) {
+    return (next_rand(state) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+// G(n, p): each row u draws its neighbors v > u with geometric skips
+// (Batagelj-Brandes), so the work is O(n + m) instead of O(n^2). Only the
+// rows [lo, hi) are drawn.
+static Edge* erdos_renyi_edges(int n, double p, unsigned long seed, int lo, int hi, eid_t* nEdges) {
+    int nBufs = omp_get_max_threads();
+    edge_buffer bufs[nBufs];
+    memset(bufs, 0, sizeof(bufs));
+    double logq = (p < 1.0) ? log(1.0 - p) : 0.0;
+
+    #pragma omp parallel for num_threads(nBufs) schedule(dynamic, 256)
+    for(int u = lo; u < hi; u++) {
+        edge_buffer* b = &bufs[omp_get_thread_num()];
+        uint64_t state = vertex_priority(seed, u);
+        if (p <= 0.0) continue;
+
+        long v = u;
+        while (1) {
+            if (p >= 1.0) {
+                v++;
+            } else {
+                double r = next_uniform(&state);
+                v += 1 + (long) floor(log(1.0 - r) / logq);
+            }
+            if (v >= n) break;
+            buffer_push(b, u, (vid_t) v);
+        }
+    }
+
+    return gather_buffers(bufs, nBufs, nEdges);
+}
+
+void generateErdosRenyi(Graph* g, int n, double p, unsigned long seed) {
+    eid_t m;
+    Edge* edges = erdos_renyi_edges(n, p, seed, 0, n, &m);
+    build_from_edges(g, n, edges, m);
+}
+
+// R-MAT / Kronecker graph with 2^scale vertices and edgeFactor * 2^scale edge
+// draws; every draw picks a quadrant with probabilities a, b, c and
+// d = 1 - a - b - c at each of the scale levels. Larger a gives more skew.
+// Only the draws [lo, hi) are made.
+static Edge* rmat_edges(int scale, double a, double b, double c, unsigned long seed, eid_t lo, eid_t hi) {
+    Edge* edges = (Edge*) malloc(sizeof(Edge) * (hi > lo ? hi - lo : 1));
+    uint64_t base = seed;
+    base = next_rand(&base);
+
+    #pragma omp parallel for schedule(static)
+    for(eid_t e = lo; e < hi; e++) {
+        // the state is a bijection of the full 64-bit draw index, draws
+        // 2^32 apart do not repeat each other
+        uint64_t state = (uint64_t) e;
+        state = next_rand(&state) ^ base;
+        vid_t u = 0, v = 0;
+        for(int level = 0; level < scale; level++) {
+            double r = next_uniform(&state);
+            u <<= 1;
+            v <<= 1;
+            if (r < a) {
+                // top left
+            } else if (r < a + b) {
+                v |= 1;
+            } else if (r < a + b + c) {
+                u |= 1;
+            } else {
+                u |= 1;
+                v |= 1;
+            }
+        }
+        edges[e - lo].u = u;
+        edges[e - lo].v = v;
+    }
+    return edges;
+}
+
+void generateRMAT(Graph* g, int scale, int edgeFactor, double a, double b, double c, unsigned long seed) {
+    int n = 1 << scale;
+    eid_t m = (eid_t) edgeFactor * n;
+    build_from_edges(g, n, rmat_edges(scale, a, b, c, seed, 0, m), m);
+}
+
+// x * y * z grid with edges to the next vertex along each axis (z = 1 for 2D);
+// every vertex in [lo, hi) adds the edges to its +x, +y and +z neighbors
+static Edge* grid_edges(int x, int y, int z, long lo, long hi, eid_t* nEdges) {
+    int nBufs = omp_get_max_threads();
+    edge_buffer bufs[nBufs];
+    memset(bufs, 0, sizeof(bufs));
+
+    #pragma omp parallel for num_threads(nBufs) schedule(static)
+    for(long v = lo; v < hi; v++) {
+        edge_buffer* b = &bufs[omp_get_thread_num()];
+        long i = v % x;
+        long j = (v / x) % y;
+        long k = v / ((long) x * y);
+        if (i + 1 < x) buffer_push(b, (vid_t) v, (vid_t) (v + 1));
+        if (j + 1 < y) buffer_push(b, (vid_t) v, (vid_t) (v + x));
+        if (k + 1 < z) buffer_push(b, (vid_t) v, (vid_t) (v + (long) x * y));
+    }
+
+    return gather_buffers(bufs, nBufs, nEdges);
+}
+
+void generateGrid(Graph* g, int x, int y, int z) {
+    long n = (long) x * y * z;
+    eid_t m;
+    Edge* edges = grid_edges(x, y, z, 0, n, &m);
+    build_from_edges(g, (int) n, edges, m);
+}
+
+// Random geometric graph: n points uniform in the unit square, joined when
+// closer than radius. Points are bucketed into cells at least radius wide,
+// so each point only checks the 3 x 3 block of cells around it. Every point
+// is placed, but only the rows [lo, hi) look for neighbors.
+static Edge* geometric_edges(int n, double radius, unsigned long seed, int lo, int hi, eid_t* nEdges) {
+    double* px = (double*) malloc(sizeof(double) * n);
+    double* py = (double*) malloc(sizeof(double) * n);
+
+    // cells are at least radius wide, and there are at most about 4n of them
+    int dim = (radius > 0.0) ? (int) (1.0 / radius) : 1;
+    int maxDim = (int) sqrt(4.0 * n) + 1;
+    if (dim > maxDim) dim = maxDim;
+    if (dim < 1) dim = 1;
+    long nCells = (long) dim * dim;
+
+    int* cellOf = (int*) malloc(sizeof(int) * n);
+    eid_t* cellStart = (eid_t*) calloc(nCells + 1, sizeof(eid_t));
+    int* cellPoints = (int*) malloc(sizeof(int) * n);
+
+    #pragma omp parallel for
+    for(int v = 0; v < n; v++) {
+        uint64_t state = vertex_priority(seed, v);
+        px[v] = next_uniform(&state);
+        py[v] = next_uniform(&state);
+        int cx = (int) (px[v] * dim);
+        int cy = (int) (py[v] * dim);
+        cellOf[v] = cy * dim + cx;
+        #pragma omp atomic
+        cellStart[cellOf[v] + 1]++;
+    }
+    for(long c = 0; c < nCells; c++) {
+        cellStart[c + 1] += cellStart[c];
+    }
+
+    // points in increasing id within each cell
+    eid_t* cursor = (eid_t*) malloc(sizeof(eid_t) * nCells);
+    memcpy(cursor, cellStart, sizeof(eid_t) * nCells);
+    for(int v = 0; v < n; v++) {
+        cellPoints[cursor[cellOf[v]]++] = v;
+    }
+    free(cursor);
+
+    int nBufs = omp_get_max_threads();
+    edge_buffer bufs[nBufs];
+    memset(bufs, 0, sizeof(bufs));
+    double r2 = radius * radius;
+
+    #pragma omp parallel for num_threads(nBufs) schedule(dynamic, 1024)
+    for(int u = lo; u < hi; u++) {
+        edge_buffer* b = &bufs[omp_get_thread_num()];
+        int cx = cellOf[u] % dim;
+        int cy = cellOf[u] / dim;
+        for(int dy = -1; dy <= 1; dy++) {
+            for(int dx = -1; dx <= 1; dx++) {
+                int nx = cx + dx;
+                int ny = cy + dy;
+                if (nx < 0 || ny < 0 || nx >= dim || ny >= dim) continue;
+                long c = (long) ny * dim + nx;
+                for(eid_t i = cellStart[c]; i < cellStart[c + 1]; i++) {
+                    int v = cellPoints[i];
+                    if (v <= u) continue;
+                    double ddx = px[u] - px[v];
+                    double ddy = py[u] - py[v];
+                    if (ddx * ddx + ddy * ddy < r2) buffer_push(b, u, v);
+                }
+            }
+        }
+    }
+
+    free(px);
+    free(py);
+    free(cellOf);
+    free(cellStart);
+    free(cellPoints);
+    return gather_buffers(bufs, nBufs, nEdges);
+}
+
+void generateGeometric(Graph* g, int n, double radius, unsigned long seed) {
+    eid_t m;
+    Edge* edges = geometric_edges(n, radius, seed, 0, n, &m);
+    build_from_edges(g, n, edges, m);
+}
+
+// Generate part of nParts of a graph from a spec string: the rows
+// [n * part / nParts, n * (part + 1) / nParts) for er, grid and geo, and the
+// same share of the edge draws for rmat. Every edge comes out of exactly one
+// part, so the parts together give the edges generateGraph builds from, for
+// any number of parts. Returns 0 on success and -1 if the spec is not understood:
+//   er:N,P               G(n, p)
+//   rmat:SCALE,EF[,A,B,C] R-MAT, defaults to the Graph500 0.57,0.19,0.19
+//   grid2d:X,Y           2D grid
+//   grid3d:X,Y,Z         3D grid
+//   geo:N,R              random geometric graph
+int generateEdges(const char* spec, unsigned long seed, int part, int nParts,
+                  Edge** edges, eid_t* nEdges, int* nVertices) {
+    long n, x, y, z;
+    int scale, ef;
+    double p, a = 0.57, b = 0.19, c = 0.19;
+
+    if (sscanf(spec, "er:%ld,%lf", &n, &p) == 2 && n > 0 && n <= INT32_MAX) {
+        *edges = erdos_renyi_edges((int) n, p, seed, (int) (n * part / nParts), (int) (n * (part + 1) / nParts), nEdges);
+    } else if (sscanf(spec, "rmat:%d,%d", &scale, &ef) == 2 && scale > 0 && scale < 31 && ef > 0) {
+        sscanf(spec, "rmat:%d,%d,%lf,%lf,%lf", &scale, &ef, &a, &b, &c);
+        if (a < 0 || b < 0 || c < 0 || a + b + c > 1.0) {
+            fprintf(stderr, "R-MAT probabilities must be non-negative and sum to at most 1\n");
+            return -1;
+        }
+        n = 1L << scale;
+        eid_t m = (eid_t) ef * n;
+        eid_t lo = m * part / nParts;
+        eid_t hi = m * (part + 1) / nParts;
+        *edges = rmat_edges(scale, a, b, c, seed, lo, hi);
+        *nEdges = hi - lo;
+    } else if (sscanf(spec, "grid2d:%ld,%ld", &x, &y) == 2 && x > 0 && y > 0 && x * y <= INT32_MAX) {
+        n = x * y;
+        *edges = grid_edges((int) x, (int) y, 1, n * part / nParts, n * (part + 1) / nParts, nEdges);
+    } else if (sscanf(spec, "grid3d:%ld,%ld,%ld", &x, &y, &z) == 3 && x > 0 && y > 0 && z > 0 && x * y * z <= INT32_MAX) {
+        n = x * y * z;
+        *edges = grid_edges((int) x, (int) y, (int) z, n * part / nParts, n * (part + 1) / nParts, nEdges);
+    } else if (sscanf(spec, "geo:%ld,%lf", &n, &p) == 2 && n > 0 && n <= INT32_MAX) {
+        *edges = geometric_edges((int) n, p, seed, (int) (n * part / nParts), (int) (n * (part + 1) / nParts), nEdges);
+    } else {
+        fprintf(stderr, "Unknown graph spec \"%s\"\n", spec);
+        return -1;
+    }
+    *nVertices = (int) n;
+    return 0;
+}
+
+// generate a graph from a spec string (see generateEdges), returns 0 on
+// success and -1 if the spec is not understood
+int generateGraph(Graph* g, const char* spec, unsigned long seed) {
+    Edge* edges;
+    eid_t m;
+    int n;
+    if (generateEdges(spec, seed, 0, 1, &edges, &m, &n) != 0) {
+        return -1;
+    }
+    build_from_edges(g, n, edges, m);
+    return 0;
+}
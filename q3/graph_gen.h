@@ -0,0 +1,14 @@
+#ifndef GRAPH_GEN_H
+#define GRAPH_GEN_H
+
+#include "color_graph.h"
+
+void generateErdosRenyi(Graph* g, int n, double p, unsigned long seed);
+void generateRMAT(Graph* g, int scale, int edgeFactor, double a, double b, double c, unsigned long seed);
+void generateGrid(Graph* g, int x, int y, int z);
+void generateGeometric(Graph* g, int n, double radius, unsigned long seed);
+int generateEdges(const char* spec, unsigned long seed, int part, int nParts,
+                  Edge** edges, eid_t* nEdges, int* nVertices);
+int generateGraph(Graph* g, const char* spec, unsigned long seed);
+
+#endif /*GRAPH_GEN_H*/
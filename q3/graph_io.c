@@ -0,0 +1,406 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <omp.h>
+#include "graph_io.h"
+
+// per-thread output of the chunked parser
+typedef struct {
+    Edge* edges;        // edges parsed from this chunk
+    eid_t n;            // number of edges parsed
+    eid_t cap;          // allocated size of edges
+    vid_t maxU;         // largest first endpoint seen (0-based)
+    vid_t maxV;         // largest second endpoint seen (0-based)
+    long bad;           // lines that could not be parsed
+} parse_chunk;
+
+static int is_space(char c) {
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+// skip to the first character of the next line
+static const char* next_line(const char* p, const char* end) {
+    const char* nl = memchr(p, '\n', end - p);
+    return nl ? nl + 1 : end;
+}
+
+// parse an unsigned integer, returns NULL if there is none before the end of
+// line or if it is past INT32_MAX + 1 (the largest 1-based id that still fits
+// a vid_t), so a corrupt id fails instead of overflowing
+static const char* parse_id(const char* p, const char* end, long* out) {
+    while (p < end && is_space(*p)) p++;
+    if (p >= end || *p < '0' || *p > '9') return NULL;
+
+    long val = 0;
+    while (p < end && *p >= '0' && *p <= '9') {
+        val = val * 10 + (*p - '0');
+        if (val > (long) INT32_MAX + 1) return NULL;
+        p++;
+    }
+    *out = val;
+    return p;
+}
+
+static void push_edge(parse_chunk* c, vid_t u, vid_t v) {
+    if (c->n == c->cap) {
+        c->cap = c->cap ? c->cap * 2 : 4096;
+        c->edges = (Edge*) realloc(c->edges, sizeof(Edge) * c->cap);
+    }
+    c->edges[c->n].u = u;
+    c->edges[c->n].v = v;
+    c->n++;
+    if (u > c->maxU) c->maxU = u;
+    if (v > c->maxV) c->maxV = v;
+}
+
+// parse every edge line in [p, end); lines are complete because chunk
+// boundaries are moved to line starts
+static void parse_range(const char* p, const char* end, graph_format fmt, parse_chunk* c) {
+    long base = (fmt == FORMAT_EDGE_LIST) ? 0 : 1;
+
+    while (p < end) {
+        const char* line = p;
+        const char* eol = memchr(p, '\n', end - p);
+        if (!eol) eol = end;
+        p = eol + 1;
+
+        while (line < eol && is_space(*line)) line++;
+        if (line == eol) continue;
+
+        // only "e u v" lines carry edges in DIMACS
+        if (fmt == FORMAT_DIMACS) {
+            if (*line != 'e') continue;
+            line++;
+        } else if (*line == '%' || *line == '#') {
+            continue;
+        }
+
+        long u, v;
+        const char* q = parse_id(line, eol, &u);
+        if (q) q = parse_id(q, eol, &v);
+        if (!q || u < base || v < base || u - base > INT32_MAX || v - base > INT32_MAX) {
+            c->bad++;
+            continue;
+        }
+        push_edge(c, (vid_t) (u - base), (vid_t) (v - base));
+    }
+}
+
+// pick the format from the first non-comment content, falling back on the extension
+graph_format detect_format(const char* path, const char* data, size_t len) {
+    const char* end = data + len;
+    const char* p = data;
+
+    if (len >= 14 && strncmp(data, "%%MatrixMarket", 14) == 0) return FORMAT_MTX;
+
+    while (p < end) {
+        const char* line = p;
+        while (line < end && is_space(*line)) line++;
+        if (line < end && (*line == 'p' || *line == 'c' || *line == 'e')) return FORMAT_DIMACS;
+        if (line < end && *line != '\n' && *line != '#' && *line != '%') break;
+        p = next_line(p, end);
+    }
+
+    const char* ext = strrchr(path, '.');
+    if (ext && strcmp(ext, ".col") == 0) return FORMAT_DIMACS;
+    if (ext && strcmp(ext, ".mtx") == 0) return FORMAT_MTX;
+    return FORMAT_EDGE_LIST;
+}
+
+// read the header of a DIMACS or Matrix Market file, returns the offset of
+// the first edge line or -1 if the header is malformed
+static long parse_header(const char* data, size_t len, graph_format fmt, long* nRows, long* nCols) {
+    const char* end = data + len;
+    const char* p = data;
+
+    while (p < end) {
+        const char* line = p;
+        const char* eol = memchr(p, '\n', end - p);
+        if (!eol) eol = end;
+        p = next_line(p, end);
+
+        while (line < eol && is_space(*line)) line++;
+        if (line == eol) continue;
+
+        if (fmt == FORMAT_DIMACS) {
+            if (*line == 'c') continue;
+            if (*line != 'p') return -1;
+
+            // "p edge N M" (the problem name may also be "col")
+            line++;
+            while (line < eol && is_space(*line)) line++;
+            while (line < eol && !is_space(*line)) line++;
+            long n;
+            if (!parse_id(line, eol, &n)) return -1;
+            *nRows = n;
+            *nCols = n;
+            return p - data;
+        } else {
+            if (*line == '%') continue;
+
+            // "rows cols nnz"
+            const char* q = parse_id(line, eol, nRows);
+            if (q) q = parse_id(q, eol, nCols);
+            if (!q) return -1;
+            return p - data;
+        }
+    }
+    return -1;
+}
+
+// a graph file mapped into memory, with its format and header
+typedef struct {
+    const char* data;
+    size_t len;
+    graph_format fmt;
+    long nRows;         // from the header, -1 for edge lists
+    long nCols;
+    long bodyStart;     // offset of the first edge line
+} mapped_graph;
+
+// map a graph file and read its header, returns 0 on success and -1 on failure
+static int map_graph(const char* path, mapped_graph* m) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        perror(path);
+        return -1;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) < 0 || st.st_size == 0) {
+        fprintf(stderr, "%s: empty or unreadable file\n", path);
+        close(fd);
+        return -1;
+    }
+    m->len = (size_t) st.st_size;
+
+    // map the whole file, parsing reads straight out of the page cache
+    m->data = (const char*) mmap(NULL, m->len, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (m->data == MAP_FAILED) {
+        perror("mmap");
+        return -1;
+    }
+    madvise((void*) m->data, m->len, MADV_SEQUENTIAL);
+
+    m->fmt = detect_format(path, m->data, m->len);
+    m->nRows = -1;
+    m->nCols = -1;
+    m->bodyStart = 0;
+    if (m->fmt != FORMAT_EDGE_LIST) {
+        m->bodyStart = parse_header(m->data, m->len, m->fmt, &m->nRows, &m->nCols);
+        if (m->bodyStart < 0) {
+            fprintf(stderr, "%s: malformed %s header\n", path, m->fmt == FORMAT_DIMACS ? "DIMACS" : "Matrix Market");
+            munmap((void*) m->data, m->len);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+// first line start at or after the byte at fraction part / nParts of [body, end)
+static const char* line_split(const char* body, const char* end, long part, long nParts) {
+    const char* p = body + ((size_t) (end - body) * part) / nParts;
+    if (p > body && p < end && p[-1] != '\n') p = next_line(p, end);
+    return p;
+}
+
+// Parse the edge lines in [body, end), which start and end on line
+// boundaries, split into one chunk per thread. Returns the edges; the largest
+// endpoints and the number of malformed lines go to maxU, maxV and bad.
+static Edge* parse_lines(const char* body, const char* end, graph_format fmt, eid_t* nEdges,
+                         vid_t* maxU, vid_t* maxV, long* bad) {
+    int nChunks = omp_get_max_threads();
+    parse_chunk chunks[nChunks];
+    memset(chunks, 0, sizeof(chunks));
+
+    #pragma omp parallel for num_threads(nChunks) schedule(static, 1)
+    for(int i = 0; i < nChunks; i++) {
+        const char* lo = line_split(body, end, i, nChunks);
+        const char* hi = line_split(body, end, i + 1, nChunks);
+        chunks[i].maxU = -1;
+        chunks[i].maxV = -1;
+        if (lo < hi) parse_range(lo, hi, fmt, &chunks[i]);
+    }
+
+    // gather the per-thread edge lists into one array
+    eid_t offsets[nChunks + 1];
+    *bad = 0;
+    *maxU = -1;
+    *maxV = -1;
+    offsets[0] = 0;
+    for(int i = 0; i < nChunks; i++) {
+        offsets[i + 1] = offsets[i] + chunks[i].n;
+        *bad += chunks[i].bad;
+        if (chunks[i].maxU > *maxU) *maxU = chunks[i].maxU;
+        if (chunks[i].maxV > *maxV) *maxV = chunks[i].maxV;
+    }
+
+    Edge* edges = (Edge*) malloc(sizeof(Edge) * (offsets[nChunks] > 0 ? offsets[nChunks] : 1));
+    #pragma omp parallel for num_threads(nChunks) schedule(static, 1)
+    for(int i = 0; i < nChunks; i++) {
+        memcpy(edges + offsets[i], chunks[i].edges, sizeof(Edge) * chunks[i].n);
+        free(chunks[i].edges);
+    }
+    *nEdges = offsets[nChunks];
+    return edges;
+}
+
+// Read a graph file into g, returns 0 on success and -1 on failure. The first
+// endpoint of every entry is a row and the second a column. Normally rows and
+// columns map onto the same vertices; when bipartite is set, columns become
+// vertices [0, nCols) and rows vertices [nCols, nCols + nRows).
+static int load_file(Graph* g, const char* path, int bipartite, int* nColumns) {
+    mapped_graph m;
+    if (map_graph(path, &m) != 0) {
+        return -1;
+    }
+
+    eid_t nEdges;
+    vid_t maxU, maxV;
+    long bad;
+    Edge* edges = parse_lines(m.data + m.bodyStart, m.data + m.len, m.fmt, &nEdges, &maxU, &maxV, &bad);
+    munmap((void*) m.data, m.len);
+
+    long nRows = m.nRows;
+    long nCols = m.nCols;
+    if (bad > 0) {
+        fprintf(stderr, "%s: skipped %ld malformed edge line(s)\n", path, bad);
+    }
+    if (nRows < 0) {
+        nRows = (long) maxU + 1;
+        nCols = (long) maxV + 1;
+        if (!bipartite) {
+            nRows = nCols = (nRows > nCols ? nRows : nCols);
+        }
+    } else if (maxU >= nRows || maxV >= nCols) {
+        fprintf(stderr, "%s: entry (%d, %d) is outside the %ld x %ld header\n", path, maxU + 1, maxV + 1, nRows, nCols);
+        free(edges);
+        return -1;
+    }
+
+    long nVertices;
+    if (bipartite) {
+        // column j -> vertex j, row i -> vertex nCols + i
+        #pragma omp parallel for
+        for(eid_t e = 0; e < nEdges; e++) {
+            vid_t row = edges[e].u;
+            edges[e].u = edges[e].v;
+            edges[e].v = (vid_t) (nCols + row);
+        }
+        nVertices = nRows + nCols;
+        *nColumns = (int) nCols;
+    } else {
+        nVertices = nRows > nCols ? nRows : nCols;
+    }
+    if (nVertices > INT32_MAX) {
+        fprintf(stderr, "%s: %ld vertices do not fit 32-bit vertex ids\n", path, nVertices);
+        free(edges);
+        return -1;
+    }
+
+    buildGraph(g, (int) nVertices, edges, nEdges);
+    free(edges);
+    return 0;
+}
+
+// load a graph file into g, returns 0 on success and -1 on failure
+int loadGraph(Graph* g, const char* path) {
+    return load_file(g, path, 0, NULL);
+}
+
+// load a file as the bipartite column/row graph of a sparse matrix, columns
+// are vertices [0, nColumns)
+int loadBipartite(Graph* g, const char* path, int* nColumns) {
+    return load_file(g, path, 1, nColumns);
+}
+
+// Parse only part of nParts of the edge lines of a graph file, split on line
+// boundaries, so a distributed run never holds the whole edge list in one
+// place. *nVertices is the vertex count from the header, or the largest id
+// in this part plus one for an edge list (the maximum over all parts is the
+// count loadGraph would use). Returns 0 on success and -1 on failure.
+int loadEdgeRange(const char* path, int part, int nParts, Edge** edges, eid_t* nEdges, long* nVertices) {
+    mapped_graph m;
+    if (map_graph(path, &m) != 0) {
+        return -1;
+    }
+
+    const char* body = m.data + m.bodyStart;
+    const char* end = m.data + m.len;
+    const char* lo = line_split(body, end, part, nParts);
+    const char* hi = line_split(body, end, part + 1, nParts);
+    vid_t maxU = -1, maxV = -1;
+    long bad = 0;
+    if (lo < hi) {
+        *edges = parse_lines(lo, hi, m.fmt, nEdges, &maxU, &maxV, &bad);
+    } else {
+        *edges = (Edge*) malloc(sizeof(Edge));
+        *nEdges = 0;
+    }
+    munmap((void*) m.data, m.len);
+
+    if (bad > 0) {
+        fprintf(stderr, "%s: skipped %ld malformed edge line(s)\n", path, bad);
+    }
+    if (m.nRows >= 0 && (maxU >= m.nRows || maxV >= m.nCols)) {
+        fprintf(stderr, "%s: entry (%d, %d) is outside the %ld x %ld header\n", path, maxU + 1, maxV + 1, m.nRows, m.nCols);
+        free(*edges);
+        return -1;
+    }
+    if (m.nRows >= 0) {
+        *nVertices = m.nRows > m.nCols ? m.nRows : m.nCols;
+    } else {
+        *nVertices = (long) (maxU > maxV ? maxU : maxV) + 1;
+    }
+    return 0;
+}
+
+// Read a batch of edge changes, one "+ u v" (insert) or "- u v" (delete) per
+// line with 0-based ids. Batches are small, so this goes through stdio.
+int loadEdgeBatch(const char* path, Edge** inserted, int* nInserted, Edge** deleted, int* nDeleted) {
+    FILE* fp = fopen(path, "r");
+    if (!fp) {
+        perror(path);
+        return -1;
+    }
+
+    int capIns = 64, capDel = 64;
+    *inserted = (Edge*) malloc(sizeof(Edge) * capIns);
+    *deleted = (Edge*) malloc(sizeof(Edge) * capDel);
+    *nInserted = 0;
+    *nDeleted = 0;
+
+    char line[256];
+    long lineNo = 0;
+    while (fgets(line, sizeof(line), fp)) {
+        char op;
+        int u, v;
+        lineNo++;
+        if (line[0] == '#' || line[0] == '%' || line[0] == '\n') continue;
+        if (sscanf(line, " %c %d %d", &op, &u, &v) != 3 || (op != '+' && op != '-')) {
+            fprintf(stderr, "%s:%ld: expected \"+ u v\" or \"- u v\"\n", path, lineNo);
+            continue;
+        }
+
+        if (op == '+') {
+            if (*nInserted == capIns) {
+                capIns *= 2;
+                *inserted = (Edge*) realloc(*inserted, sizeof(Edge) * capIns);
+            }
+            (*inserted)[(*nInserted)++] = (Edge) { u, v };
+        } else {
+            if (*nDeleted == capDel) {
+                capDel *= 2;
+                *deleted = (Edge*) realloc(*deleted, sizeof(Edge) * capDel);
+            }
+            (*deleted)[(*nDeleted)++] = (Edge) { u, v };
+        }
+    }
+    fclose(fp);
+    return 0;
+}
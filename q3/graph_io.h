@@ -0,0 +1,18 @@
+#ifndef GRAPH_IO_H
+#define GRAPH_IO_H
+
+#include "color_graph.h"
+
+typedef enum {
+    FORMAT_EDGE_LIST,   // "u v" per line, 0-based ids, '#' or '%' comments
+    FORMAT_DIMACS,      // "p edge N M" header then "e u v" lines, 1-based ids
+    FORMAT_MTX          // Matrix Market coordinate file, 1-based ids
+} graph_format;
+
+graph_format detect_format(const char* path, const char* data, size_t len);
+int loadGraph(Graph* g, const char* path);
+int loadBipartite(Graph* g, const char* path, int* nColumns);
+int loadEdgeRange(const char* path, int part, int nParts, Edge** edges, eid_t* nEdges, long* nVertices);
+int loadEdgeBatch(const char* path, Edge** inserted, int* nInserted, Edge** deleted, int* nDeleted);
+
+#endif /*GRAPH_IO_H*/
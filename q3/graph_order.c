@@ -0,0 +1,511 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <omp.h>
+#include "graph_order.h"
+
+static const char* order_names[] = { "natural", "random", "lf", "sl", "id" };
+static const char* relabel_names[] = { "none", "rcm", "bfs", "degree" };
+
+// map a command line name to an ordering, returns -1 if unknown
+int parse_order(const char* name, vertex_order* ord) {
+    for(int i = 0; i <= ORDER_INCIDENCE_DEGREE; i++) {
+        if (strcmp(name, order_names[i]) == 0) {
+            *ord = (vertex_order) i;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+const char* order_name(vertex_order ord) {
+    return order_names[ord];
+}
+
+// stable parallel LSD radix sort of items by 32-bit keys, one byte per pass;
+// the blocks follow the team that actually runs, which can be smaller than
+// asked for (nested regions, thread limits, dynamic teams)
+void radix_sort_by_key(uint32_t* keys, int* items, int n) {
+    int nBlocks = omp_get_max_threads();
+    uint32_t* keyBuf = (uint32_t*) malloc(sizeof(uint32_t) * (n > 0 ? n : 1));
+    int* itemBuf = (int*) malloc(sizeof(int) * (n > 0 ? n : 1));
+    int (*hist)[256] = malloc(sizeof(int[256]) * nBlocks);
+
+    for(int shift = 0; shift < 32; shift += 8) {
+        #pragma omp parallel num_threads(nBlocks)
+        {
+            int t = omp_get_thread_num();
+            int nt = omp_get_num_threads();
+            int lo = (int) (((long) n * t) / nt);
+            int hi = (int) (((long) n * (t + 1)) / nt);
+
+            // count digits in own block
+            memset(hist[t], 0, sizeof(hist[t]));
+            for(int i = lo; i < hi; i++) {
+                hist[t][(keys[i] >> shift) & 0xFF]++;
+            }
+
+            // turn counts into scatter positions: digit-major, then thread order
+            #pragma omp barrier
+            #pragma omp single
+            {
+                int pos = 0;
+                for(int d = 0; d < 256; d++) {
+                    for(int b = 0; b < nt; b++) {
+                        int c = hist[b][d];
+                        hist[b][d] = pos;
+                        pos += c;
+                    }
+                }
+            }
+
+            for(int i = lo; i < hi; i++) {
+                int p = hist[t][(keys[i] >> shift) & 0xFF]++;
+                keyBuf[p] = keys[i];
+                itemBuf[p] = items[i];
+            }
+        }
+        memcpy(keys, keyBuf, sizeof(uint32_t) * n);
+        memcpy(items, itemBuf, sizeof(int) * n);
+    }
+
+    free(hist);
+    free(keyBuf);
+    free(itemBuf);
+}
+
+// order vertices by a key computed per vertex, ties keep id order
+static int* order_by_key(Graph* g, int largestFirst, unsigned long seed) {
+    int vert = g->nVertices;
+    int* order = (int*) malloc(sizeof(int) * vert);
+    uint32_t* keys = (uint32_t*) malloc(sizeof(uint32_t) * vert);
+
+    #pragma omp parallel for
+    for(int v = 0; v < vert; v++) {
+        order[v] = v;
+        keys[v] = largestFirst ? (uint32_t) (g->maxDegree - DEGREE(g, v)) : (uint32_t) vertex_priority(seed, v);
+    }
+    radix_sort_by_key(keys, order, vert);
+
+    free(keys);
+    return order;
+}
+
+// Split the vertices of list[0..n) that are still present by their degree:
+// those at most k go to low, the others to rest, both in list order. Every
+// thread handles one block, so the split is stable and parallel. Returns the
+// number of vertices in rest; *nLow gets the number in low and *restMin the
+// smallest degree in rest.
+static int split_level(const int* list, int n, const int* degree, const char* removed, int k,
+                       int* low, int* rest, int* nLow, int* restMin) {
+    int nBlocks = omp_get_max_threads();
+    int blockMin[nBlocks];
+    for(int b = 0; b < nBlocks; b++) blockMin[b] = INT_MAX;
+    int lowStart[nBlocks + 1];
+    int restStart[nBlocks + 1];
+    lowStart[0] = 0;
+    restStart[0] = 0;
+    int team = 0;
+
+    #pragma omp parallel num_threads(nBlocks)
+    {
+        int t = omp_get_thread_num();
+        int nt = omp_get_num_threads();
+        int lo = (int) (((long) n * t) / nt);
+        int hi = (int) (((long) n * (t + 1)) / nt);
+
+        int nl = 0, nr = 0, m = INT_MAX;
+        for(int i = lo; i < hi; i++) {
+            int v = list[i];
+            if (removed[v]) continue;
+            if (degree[v] <= k) {
+                nl++;
+            } else {
+                nr++;
+                if (degree[v] < m) m = degree[v];
+            }
+        }
+        lowStart[t + 1] = nl;
+        restStart[t + 1] = nr;
+        blockMin[t] = m;
+
+        // the team can be smaller than nBlocks, only its blocks are filled
+        #pragma omp barrier
+        #pragma omp single
+        {
+            team = nt;
+            for(int b = 1; b <= nt; b++) {
+                lowStart[b] += lowStart[b - 1];
+                restStart[b] += restStart[b - 1];
+            }
+        }
+
+        int pl = lowStart[t], pr = restStart[t];
+        for(int i = lo; i < hi; i++) {
+            int v = list[i];
+            if (removed[v]) continue;
+            if (degree[v] <= k) low[pl++] = v; else rest[pr++] = v;
+        }
+    }
+    *nLow = lowStart[team];
+    *restMin = INT_MAX;
+    for(int b = 0; b < nBlocks; b++) {
+        if (blockMin[b] < *restMin) *restMin = blockMin[b];
+    }
+    return restStart[team];
+}
+
+// Smallest-last ordering by parallel k-core peeling. Level k removes every
+// vertex whose remaining degree is at most k; removing a frontier lowers the
+// degree of its neighbors, and those that drop to k join the next frontier
+// of the same level. Colored in reverse removal order, every vertex sees at
+// most k earlier neighbors, so greedy needs at most degeneracy + 1 colors.
+// The vertices still present are kept in an array in id order that every
+// level compacts, so a level only touches the vertices left in the graph.
+// After level k every vertex left has a degree above k, so the next level is
+// usually k + 1 and one pass finds its frontier; only when nothing is left at
+// k + 1 is the array split again at its smallest degree.
+static int* smallest_last(Graph* g, uint32_t* level) {
+    int vert = g->nVertices;
+    int* order = (int*) malloc(sizeof(int) * vert);
+    int* degree = (int*) malloc(sizeof(int) * vert);
+    char* removed = (char*) calloc(vert > 0 ? vert : 1, 1);
+    int* frontier = (int*) malloc(sizeof(int) * vert);
+    int* next = (int*) malloc(sizeof(int) * vert);
+    int* present = (int*) malloc(sizeof(int) * vert);
+    int* kept = (int*) malloc(sizeof(int) * vert);
+
+    #pragma omp parallel for
+    for(int v = 0; v < vert; v++) {
+        degree[v] = DEGREE(g, v);
+        present[v] = v;
+    }
+
+    int nPresent = vert;
+    int nRemoved = 0;
+    int k = -1;
+    while (nRemoved < vert) {
+        // the initial frontier of level k is every remaining vertex of degree <= k
+        int nFrontier, minDegree;
+        k++;
+        int nKept = split_level(present, nPresent, degree, removed, k, frontier, kept, &nFrontier, &minDegree);
+        if (nFrontier == 0) {
+            k = minDegree;
+            nKept = split_level(present, nPresent, degree, removed, k, frontier, kept, &nFrontier, &minDegree);
+        }
+        int* tmp = present; present = kept; kept = tmp;
+        nPresent = nKept;
+
+        while (nFrontier > 0) {
+            #pragma omp parallel for
+            for(int i = 0; i < nFrontier; i++) {
+                removed[frontier[i]] = 1;
+                if (level) level[frontier[i]] = (uint32_t) k;
+            }
+            memcpy(order + nRemoved, frontier, sizeof(int) * nFrontier);
+            nRemoved += nFrontier;
+
+            // decrement remaining neighbors, collect the ones crossing down to k
+            int nNext = 0;
+            #pragma omp parallel for schedule(dynamic, 256)
+            for(int i = 0; i < nFrontier; i++) {
+                int u = frontier[i];
+                for(eid_t e = g->offsets[u]; e < g->offsets[u + 1]; e++) {
+                    int w = g->adj[e];
+                    int old;
+                    if (removed[w]) continue;
+                    // vertices already down to k are in this level's frontier
+                    #pragma omp atomic read
+                    old = degree[w];
+                    if (old <= k) continue;
+                    #pragma omp atomic capture
+                    old = degree[w]--;
+                    if (old == k + 1) {
+                        int pos;
+                        #pragma omp atomic capture
+                        pos = nNext++;
+                        next[pos] = w;
+                    }
+                }
+            }
+
+            // keep the result independent of thread timing
+            sort_ids(next, nNext);
+            tmp = frontier; frontier = next; next = tmp;
+            nFrontier = nNext;
+        }
+    }
+
+    // smallest last: the last vertex removed is colored first
+    for(int i = 0; i < vert / 2; i++) {
+        int tmp = order[i];
+        order[i] = order[vert - 1 - i];
+        order[vert - 1 - i] = tmp;
+    }
+
+    free(degree);
+    free(removed);
+    free(frontier);
+    free(next);
+    free(present);
+    free(kept);
+    return order;
+}
+
+// Incidence-degree ordering: repeatedly take the vertex with the most
+// neighbors already in the order. Each step depends on the previous one, so
+// this runs sequentially over a bucket queue in O(V + E).
+static int* incidence_degree(Graph* g) {
+    int vert = g->nVertices;
+    int maxBucket = g->maxDegree + 1;
+    int* order = (int*) malloc(sizeof(int) * vert);
+    int* incidence = (int*) calloc(vert > 0 ? vert : 1, sizeof(int));
+    int* head = (int*) malloc(sizeof(int) * maxBucket);
+    int* prev = (int*) malloc(sizeof(int) * vert);
+    int* nextv = (int*) malloc(sizeof(int) * vert);
+    char* placed = (char*) calloc(vert > 0 ? vert : 1, 1);
+
+    // every vertex starts in bucket 0, linked in decreasing id so the
+    // smallest id is taken first among ties
+    for(int b = 0; b < maxBucket; b++) head[b] = -1;
+    for(int v = vert - 1; v >= 0; v--) {
+        prev[v] = -1;
+        nextv[v] = head[0];
+        if (head[0] != -1) prev[head[0]] = v;
+        head[0] = v;
+    }
+
+    int top = 0;
+    for(int i = 0; i < vert; i++) {
+        while (head[top] == -1) top--;
+        int u = head[top];
+
+        // unlink u
+        head[top] = nextv[u];
+        if (nextv[u] != -1) prev[nextv[u]] = -1;
+        placed[u] = 1;
+        order[i] = u;
+
+        // move unplaced neighbors up one bucket
+        for(eid_t e = g->offsets[u]; e < g->offsets[u + 1]; e++) {
+            int w = g->adj[e];
+            if (placed[w]) continue;
+            int b = incidence[w];
+            if (prev[w] != -1) nextv[prev[w]] = nextv[w]; else head[b] = nextv[w];
+            if (nextv[w] != -1) prev[nextv[w]] = prev[w];
+
+            incidence[w] = ++b;
+            prev[w] = -1;
+            nextv[w] = head[b];
+            if (head[b] != -1) prev[head[b]] = w;
+            head[b] = w;
+            if (b > top) top = b;
+        }
+    }
+
+    free(incidence);
+    free(head);
+    free(prev);
+    free(nextv);
+    free(placed);
+    return order;
+}
+
+// Compute the order in which the coloring algorithms visit vertices. With
+// rank set, *rank gets the coarse key Jones-Plassmann uses in place of the
+// order (NULL when the order has none): a strict order would leave it one
+// vertex per round along every chain of neighbors, so only the degree for lf
+// and the peel level for sl are kept and the seed breaks the ties.
+int* orderVertices(Graph* g, vertex_order ord, unsigned long seed, uint32_t** rank) {
+    if (g->pending != NULL) {
+        finalizeGraph(g);
+    }
+
+    uint32_t* key = NULL;
+    if (rank && (ord == ORDER_LARGEST_FIRST || ord == ORDER_SMALLEST_LAST)) {
+        key = (uint32_t*) malloc(sizeof(uint32_t) * (g->nVertices > 0 ? g->nVertices : 1));
+    }
+    if (rank) *rank = key;
+
+    switch (ord) {
+        case ORDER_RANDOM:
+            return order_by_key(g, 0, seed);
+        case ORDER_LARGEST_FIRST:
+            if (key) {
+                #pragma omp parallel for
+                for(int v = 0; v < g->nVertices; v++) {
+                    key[v] = (uint32_t) DEGREE(g, v);
+                }
+            }
+            return order_by_key(g, 1, seed);
+        case ORDER_SMALLEST_LAST:
+            return smallest_last(g, key);
+        case ORDER_INCIDENCE_DEGREE:
+            return incidence_degree(g);
+        default: {
+            int* order = (int*) malloc(sizeof(int) * g->nVertices);
+            #pragma omp parallel for
+            for(int v = 0; v < g->nVertices; v++) {
+                order[v] = v;
+            }
+            return order;
+        }
+    }
+}
+
+// map a command line name to a relabeling, returns -1 if unknown
+int parse_relabel(const char* name, relabel_kind* kind) {
+    for(int i = 0; i <= RELABEL_DEGREE; i++) {
+        if (strcmp(name, relabel_names[i]) == 0) {
+            *kind = (relabel_kind) i;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+const char* relabel_name(relabel_kind kind) {
+    return relabel_names[kind];
+}
+
+// breadth-first search from start over unvisited vertices, appending them to
+// order; with byDegree the children of each vertex are queued by increasing
+// degree (Cuthill-McKee). Returns the new length of order.
+static int bfs_component(Graph* g, int start, char* visited, int* order, int n, int byDegree) {
+    int head = n;
+    order[n++] = start;
+    visited[start] = 1;
+
+    while (head < n) {
+        int u = order[head++];
+        int first = n;
+        for(eid_t e = g->offsets[u]; e < g->offsets[u + 1]; e++) {
+            int w = g->adj[e];
+            if (!visited[w]) {
+                visited[w] = 1;
+                order[n++] = w;
+            }
+        }
+
+        // rows are sorted by id, insertion sort keeps id order among equal degrees
+        if (byDegree) {
+            for(int i = first + 1; i < n; i++) {
+                int w = order[i];
+                int k = i - 1;
+                while (k >= first && DEGREE(g, order[k]) > DEGREE(g, w)) {
+                    order[k + 1] = order[k];
+                    k--;
+                }
+                order[k + 1] = w;
+            }
+        }
+    }
+    return n;
+}
+
+// pick a pseudo-peripheral start vertex for the component of v (George-Liu):
+// move to the smallest degree vertex of the last BFS level while the number
+// of levels keeps growing
+static int pseudo_peripheral(Graph* g, int v, int* level, int* queue) {
+    int bestDepth = -1;
+    for(int iter = 0; iter < 4; iter++) {
+        int head = 0, tail = 0;
+        queue[tail++] = v;
+        level[v] = 0;
+        int depth = 0;
+        while (head < tail) {
+            int u = queue[head++];
+            depth = level[u];
+            for(eid_t e = g->offsets[u]; e < g->offsets[u + 1]; e++) {
+                int w = g->adj[e];
+                if (level[w] < 0) {
+                    level[w] = level[u] + 1;
+                    queue[tail++] = w;
+                }
+            }
+        }
+
+        // smallest degree vertex in the last level
+        int next = v;
+        for(int i = tail - 1; i >= 0 && level[queue[i]] == depth; i--) {
+            if (next == v || DEGREE(g, queue[i]) < DEGREE(g, next)) next = queue[i];
+        }
+        for(int i = 0; i < tail; i++) {
+            level[queue[i]] = -1;
+        }
+
+        if (depth <= bestDepth) break;
+        bestDepth = depth;
+        v = next;
+    }
+    return v;
+}
+
+// Reverse Cuthill-McKee: each component is visited breadth-first from a
+// pseudo-peripheral vertex, children by increasing degree, and the whole
+// order is reversed. This is a sequential pass, cheap next to the coloring.
+static int* rcm_order(Graph* g) {
+    int vert = g->nVertices;
+    int* order = (int*) malloc(sizeof(int) * vert);
+    char* visited = (char*) calloc(vert > 0 ? vert : 1, 1);
+    int* level = (int*) malloc(sizeof(int) * vert);
+    int* queue = (int*) malloc(sizeof(int) * vert);
+
+    // components are started from their smallest degree vertex
+    int* byDegree = order_by_key(g, 1, 0);
+    for(int i = 0; i < vert; i++) {
+        level[i] = -1;
+    }
+
+    int n = 0;
+    for(int i = vert - 1; i >= 0; i--) {
+        int v = byDegree[i];
+        if (visited[v]) continue;
+        v = pseudo_peripheral(g, v, level, queue);
+        n = bfs_component(g, v, visited, order, n, 1);
+    }
+
+    for(int i = 0; i < vert / 2; i++) {
+        int tmp = order[i];
+        order[i] = order[vert - 1 - i];
+        order[vert - 1 - i] = tmp;
+    }
+
+    free(byDegree);
+    free(visited);
+    free(level);
+    free(queue);
+    return order;
+}
+
+// Compute new vertex ids for better locality: order[i] is the input id of the
+// vertex that becomes vertex i. Use with permuteGraph.
+int* relabelOrder(Graph* g, relabel_kind kind) {
+    if (g->pending != NULL) {
+        finalizeGraph(g);
+    }
+
+    if (kind == RELABEL_RCM) {
+        return rcm_order(g);
+    }
+    if (kind == RELABEL_DEGREE) {
+        return order_by_key(g, 1, 0);
+    }
+
+    int vert = g->nVertices;
+    int* order = (int*) malloc(sizeof(int) * vert);
+    if (kind == RELABEL_BFS) {
+        char* visited = (char*) calloc(vert > 0 ? vert : 1, 1);
+        int n = 0;
+        for(int v = 0; v < vert; v++) {
+            if (!visited[v]) n = bfs_component(g, v, visited, order, n, 0);
+        }
+        free(visited);
+    } else {
+        for(int v = 0; v < vert; v++) {
+            order[v] = v;
+        }
+    }
+    return order;
+}
@@ -0,0 +1,29 @@
+#ifndef GRAPH_ORDER_H
+#define GRAPH_ORDER_H
+
+#include "color_graph.h"
+
+typedef enum {
+    ORDER_NATURAL,          // vertex id order
+    ORDER_RANDOM,           // random permutation from the seed
+    ORDER_LARGEST_FIRST,    // decreasing degree
+    ORDER_SMALLEST_LAST,    // reverse of a degeneracy (k-core peeling) order
+    ORDER_INCIDENCE_DEGREE  // most already-ordered neighbors first
+} vertex_order;
+
+typedef enum {
+    RELABEL_NONE,           // keep the input ids
+    RELABEL_RCM,            // reverse Cuthill-McKee
+    RELABEL_BFS,            // breadth-first order from the lowest id of each component
+    RELABEL_DEGREE          // decreasing degree
+} relabel_kind;
+
+int parse_order(const char* name, vertex_order* ord);
+const char* order_name(vertex_order ord);
+void radix_sort_by_key(uint32_t* keys, int* items, int n);
+int* orderVertices(Graph* g, vertex_order ord, unsigned long seed, uint32_t** rank);
+int parse_relabel(const char* name, relabel_kind* kind);
+const char* relabel_name(relabel_kind kind);
+int* relabelOrder(Graph* g, relabel_kind kind);
+
+#endif /*GRAPH_ORDER_H*/